@@ -0,0 +1,76 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+
+/**
+ * @file autosave_worker.hpp
+ * @author Otto Link (otto.link.bv@gmail.com)
+ * @brief Defines the AutosaveWorker class, writing graph snapshots to disk on a
+ * background thread.
+ * @copyright Copyright (c) 2024 Otto Link. Distributed under the terms of the
+ * GNU General Public License. See the file LICENSE for the full license.
+ */
+#pragma once
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "gnodegui/graph_record.hpp"
+
+namespace gngui
+{
+
+/**
+ * @class AutosaveWorker
+ * @brief Serializes and writes graph snapshots on a dedicated thread.
+ *
+ * Snapshots are handed over by the caller, submitting one never blocks (only the
+ * most recent snapshot is kept if the thread is still busy writing the previous one).
+ * Their items are sorted (see sort_graph_record) and serialized on the worker thread.
+ * Files are written atomically (temporary file, then rename).
+ */
+class AutosaveWorker
+{
+public:
+  AutosaveWorker();
+
+  /**
+   * @brief Waits for the save in progress (if any) and stops the thread, a pending
+   * snapshot not yet started is dropped.
+   */
+  ~AutosaveWorker();
+
+  /**
+   * @brief Queues a snapshot to be written in the binary graph format (see
+   * graph_binary.hpp), replacing the pending one if the previous save is not done.
+   * @param snapshot Graph snapshot, items in any order.
+   * @param fname    Output file name.
+   * @param compress Whether the file is compressed (see graph_compression.hpp), on the
+   * worker thread as the serialization.
+   */
+  void submit(GraphRecord      &&snapshot,
+              const std::string &fname,
+              bool               compress = false);
+
+  /**
+   * @brief Blocks until no snapshot is pending or being written.
+   */
+  void wait_idle();
+
+private:
+  std::thread             thread;
+  std::mutex              mutex;
+  std::condition_variable cv;
+
+  std::unique_ptr<GraphRecord> pending_snapshot; /**< Next snapshot to save. */
+  std::string                  pending_fname;
+  bool                         pending_compress = false;
+  bool                         is_busy = false;
+  bool                         is_stopping = false;
+
+  void run();
+};
+
+} // namespace gngui
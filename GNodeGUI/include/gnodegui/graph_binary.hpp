@@ -0,0 +1,161 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+
+/**
+ * @file graph_binary.hpp
+ * @author Otto Link (otto.link.bv@gmail.com)
+ * @brief Compact binary serialization of a GraphRecord.
+ *
+ * Layout (version 1, all integers and floats little-endian):
+ *
+ * @code
+ * char[4] magic "GNGB"
+ * u32     version
+ * u32     string count, then for each string: u32 size + bytes (no terminator)
+ * u32     graph id (string index)
+ * i32     current link type
+ * u32     node count, then fixed-width node records (28 bytes):
+ *           u32 id, u32 caption, f64 x, f64 y, u32 flags (bit 0: widget visible)
+ * u32     link count, then fixed-width link records (20 bytes):
+ *           u32 node out id, u32 port out id, u32 node in id, u32 port in id,
+ *           i32 link type
+ * u32     group count, then fixed-width group records (40 bytes):
+ *           u32 caption, f64 x, f64 y, f64 width, f64 height, u8 rgba[4]
+ * @endcode
+ *
+ * Every string (node ids, port ids, captions) is stored once in the string table and
+ * referenced by its index in the records. The records having a fixed width, they can be
+ * read in place and in any order (see GraphBinaryView).
+ *
+ * @copyright Copyright (c) 2024 Otto Link. Distributed under the terms of the
+ * GNU General Public License. See the file LICENSE for the full license.
+ */
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gnodegui/graph_record.hpp"
+
+namespace gngui
+{
+
+/**
+ * @struct NodeRecordView
+ * @brief Node record whose strings are views on the binary buffer.
+ */
+struct NodeRecordView
+{
+  std::string_view id;
+  std::string_view caption;
+  bool             is_widget_visible = true;
+  double           x = 0.0;
+  double           y = 0.0;
+
+  /**
+   * @brief Returns a copy of the record owning its strings.
+   * @return Node record.
+   */
+  NodeRecord to_record() const;
+};
+
+/**
+ * @struct LinkRecordView
+ * @brief Link record whose strings are views on the binary buffer.
+ */
+struct LinkRecordView
+{
+  std::string_view node_out_id;
+  std::string_view port_out_id;
+  std::string_view node_in_id;
+  std::string_view port_in_id;
+  int              link_type = 0;
+
+  /**
+   * @brief Returns a copy of the record owning its strings.
+   * @return Link record.
+   */
+  LinkRecord to_record() const;
+};
+
+/**
+ * @class GraphBinaryView
+ * @brief Read-only access to a binary graph buffer without decoding it: only the header
+ * and the string table are parsed on construction, the records are read on demand and
+ * their strings are views on the buffer.
+ *
+ * The buffer (for instance a memory-mapped file) must outlive the view and the records
+ * returned by it.
+ */
+class GraphBinaryView
+{
+public:
+  /**
+   * @brief Constructor.
+   * @param buffer Input buffer, see graph_binary.hpp for the layout.
+   * @throw std::runtime_error If the buffer is not a valid binary graph.
+   */
+  GraphBinaryView(std::string_view buffer);
+
+  int get_current_link_type() const { return this->current_link_type; }
+
+  GroupRecord get_group(size_t index) const;
+
+  std::string_view get_id() const { return this->id; }
+
+  LinkRecordView get_link(size_t index) const;
+
+  size_t get_ngroups() const { return this->ngroups; }
+
+  size_t get_nlinks() const { return this->nlinks; }
+
+  size_t get_nnodes() const { return this->nnodes; }
+
+  NodeRecordView get_node(size_t index) const;
+
+  /**
+   * @brief Decodes the whole buffer.
+   * @return Graph record.
+   */
+  GraphRecord to_record() const;
+
+private:
+  std::string_view              buffer;
+  std::vector<std::string_view> strings;
+  std::string_view              id;
+  int                           current_link_type = 0;
+  size_t                        nnodes = 0;
+  size_t                        nlinks = 0;
+  size_t                        ngroups = 0;
+  size_t                        nodes_offset = 0;
+  size_t                        links_offset = 0;
+  size_t                        groups_offset = 0;
+
+  std::string_view get_string(uint32_t index) const;
+};
+
+/**
+ * @brief Returns true if the buffer starts with the binary graph magic number.
+ * @param  buffer Input buffer.
+ * @return        Detection result.
+ */
+bool is_graph_binary(std::string_view buffer);
+
+/**
+ * @brief Decodes a binary graph buffer.
+ * @param  buffer Input buffer, see graph_binary.hpp for the layout.
+ * @return        Graph record.
+ * @throw std::runtime_error If the buffer is not a valid binary graph.
+ */
+GraphRecord graph_record_from_binary(std::string_view buffer);
+
+/**
+ * @brief Encodes a graph record into the binary layout.
+ * @param  record Graph record.
+ * @return        Binary buffer.
+ */
+std::string graph_record_to_binary(const GraphRecord &record);
+
+} // namespace gngui
@@ -0,0 +1,62 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+
+/**
+ * @file graph_compression.hpp
+ * @author Otto Link (otto.link.bv@gmail.com)
+ * @brief Block compression of serialized graphs (JSON or binary).
+ *
+ * The payload is cut in fixed-size blocks compressed independently (zlib streams), so
+ * that they can be compressed and decompressed in parallel. Layout (version 1, all
+ * integers little-endian):
+ *
+ * @code
+ * char[4] magic "GNGZ"
+ * u32     version
+ * u32     block count
+ * u32     raw size, u32 compressed size, for each block
+ * bytes   compressed blocks, in order
+ * @endcode
+ *
+ * zlib is used directly when available at build time (GNODEGUI_USE_ZLIB), Qt qCompress
+ * otherwise, both produce the same streams.
+ *
+ * @copyright Copyright (c) 2024 Otto Link. Distributed under the terms of the
+ * GNU General Public License. See the file LICENSE for the full license.
+ */
+#pragma once
+#include <string>
+#include <string_view>
+
+namespace gngui
+{
+
+/**
+ * @brief Compresses a buffer, blocks are processed in parallel.
+ * @param  buffer     Input buffer.
+ * @param  level      Compression level, from 0 (none) to 9 (best), -1 for the default.
+ * @param  block_size Size of the uncompressed blocks, at most 64 MiB.
+ * @return            Compressed buffer.
+ */
+std::string graph_compress(std::string_view buffer,
+                           int              level = -1,
+                           size_t           block_size = 1 << 20);
+
+/**
+ * @brief Decompresses a buffer from graph_compress, blocks are processed in parallel.
+ * @param  buffer Compressed buffer.
+ * @return        Uncompressed buffer.
+ * @throw std::runtime_error If the buffer is not valid, including block sizes above
+ *        64 MiB or beyond what deflate can expand the compressed size to.
+ */
+std::string graph_decompress(std::string_view buffer);
+
+/**
+ * @brief Returns true if the buffer starts with the compressed graph magic number.
+ * @param  buffer Input buffer.
+ * @return        Detection result.
+ */
+bool is_graph_compressed(std::string_view buffer);
+
+} // namespace gngui
@@ -0,0 +1,50 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+
+/**
+ * @file graph_json_sax.hpp
+ * @author Otto Link (otto.link.bv@gmail.com)
+ * @brief Streaming reader of the graph JSON layout (see GraphViewer::json_to), based on
+ * the nlohmann SAX interface.
+ * @copyright Copyright (c) 2024 Otto Link. Distributed under the terms of the
+ * GNU General Public License. See the file LICENSE for the full license.
+ */
+#pragma once
+#include <functional>
+#include <istream>
+
+#include "gnodegui/graph_record.hpp"
+
+namespace gngui
+{
+
+/**
+ * @struct GraphJsonSaxCallbacks
+ * @brief Callbacks invoked by read_graph_json_sax as soon as each top-level value or
+ * record has been read. Any callback can be left empty.
+ *
+ * Records arrive in the file order: the groups come first, then the nodes and the links
+ * for a file written by graph_record_dump (GraphViewer saves), the links before the
+ * nodes with the nlohmann default (sorted keys).
+ */
+struct GraphJsonSaxCallbacks
+{
+  std::function<void(const std::string &id)> on_id;
+  std::function<void(int link_type)>          on_current_link_type;
+  std::function<void(GroupRecord &&record)>   on_group;
+  std::function<void(LinkRecord &&record)>    on_link;
+  std::function<void(NodeRecord &&record)>    on_node;
+};
+
+/**
+ * @brief Reads a graph JSON document from a stream without building the document tree,
+ * only one record (node, link or group) is held in memory at a time.
+ * @param is        Input stream.
+ * @param callbacks Record callbacks.
+ * @throw std::runtime_error On a JSON syntax error.
+ * @throw nlohmann::json::exception If a record does not have the expected layout.
+ */
+void read_graph_json_sax(std::istream &is, const GraphJsonSaxCallbacks &callbacks);
+
+} // namespace gngui
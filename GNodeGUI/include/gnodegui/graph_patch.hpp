@@ -0,0 +1,79 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+
+/**
+ * @file graph_patch.hpp
+ * @author Otto Link (otto.link.bv@gmail.com)
+ * @brief Delta between two states of a graph, expressed on the graph records.
+ * @copyright Copyright (c) 2024 Otto Link. Distributed under the terms of the
+ * GNU General Public License. See the file LICENSE for the full license.
+ */
+#pragma once
+#include <istream>
+#include <optional>
+
+#include "gnodegui/graph_record.hpp"
+
+namespace gngui
+{
+
+/**
+ * @struct GraphPatch
+ * @brief Changes to apply to a graph. Nodes are matched by id and links by their node
+ * and port ids.
+ *
+ * The changes are applied in this order: clear, removed links, removed nodes, added
+ * nodes, moved nodes, added links, groups and link type.
+ */
+struct GraphPatch
+{
+  bool                     clear = false; /**< Start from an empty graph. */
+  std::vector<LinkRecord>  removed_links;
+  std::vector<std::string> removed_nodes; /**< Node ids. */
+  std::vector<NodeRecord>  added_nodes;
+  std::vector<NodeRecord>  moved_nodes; /**< New state of existing nodes. */
+  std::vector<LinkRecord>  added_links;
+
+  std::optional<std::vector<GroupRecord>> groups; /**< Whole group list, if changed. */
+  std::optional<int> current_link_type;           /**< If changed. */
+
+  /**
+   * @brief Returns true if the patch does not change anything.
+   */
+  bool is_empty() const;
+};
+
+/**
+ * @brief Applies a patch to a graph record. Removing or moving unknown items is
+ * silently ignored.
+ * @param record Graph record, modified in place.
+ * @param patch  Patch.
+ */
+void apply_graph_patch(GraphRecord &record, const GraphPatch &patch);
+
+/**
+ * @brief Replays a journal (one JSON patch per line, see GraphViewer::save_journal) on
+ * a graph record.
+ * @param record Graph record, modified in place.
+ * @param is     Journal stream.
+ * @throw nlohmann::json::exception On an invalid line.
+ */
+void apply_graph_journal(GraphRecord &record, std::istream &is);
+
+/**
+ * @brief Computes the patch turning a graph into another one: nodes are matched by id,
+ * links by their node and port ids. Nodes whose state changed (position, caption...)
+ * are reported as moved, the group list is replaced as a whole if any group differs.
+ * @param  from Initial graph.
+ * @param  to   Target graph.
+ * @return      Patch, apply_graph_patch(from, patch) gives 'to' (up to the item order).
+ */
+GraphPatch graph_diff(const GraphRecord &from, const GraphRecord &to);
+
+bool is_same_link(const LinkRecord &a, const LinkRecord &b);
+
+GraphPatch     graph_patch_from_json(const nlohmann::json &json);
+nlohmann::json graph_patch_to_json(const GraphPatch &patch);
+
+} // namespace gngui
@@ -0,0 +1,106 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+
+/**
+ * @file graph_record.hpp
+ * @author Otto Link (otto.link.bv@gmail.com)
+ * @brief Plain records describing the serialized state of a graph (nodes, links and
+ * groups), independent of the Qt scene items.
+ * @copyright Copyright (c) 2024 Otto Link. Distributed under the terms of the
+ * GNU General Public License. See the file LICENSE for the full license.
+ */
+#pragma once
+#include <array>
+#include <string>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+namespace gngui
+{
+
+/**
+ * @struct NodeRecord
+ * @brief Serialized state of a GraphicsNode.
+ */
+struct NodeRecord
+{
+  std::string id;
+  std::string caption;
+  bool        is_widget_visible = true;
+  double      x = 0.0; /**< Scene position. */
+  double      y = 0.0;
+
+  bool operator==(const NodeRecord &) const = default;
+};
+
+/**
+ * @struct LinkRecord
+ * @brief Serialized state of a GraphicsLink, ends are given by node and port ids.
+ */
+struct LinkRecord
+{
+  std::string node_out_id;
+  std::string port_out_id;
+  std::string node_in_id;
+  std::string port_in_id;
+  int         link_type = 0; /**< LinkType value. */
+};
+
+/**
+ * @struct GroupRecord
+ * @brief Serialized state of a GraphicsGroup.
+ */
+struct GroupRecord
+{
+  std::string        caption;
+  double             x = 0.0; /**< Scene position of the top-left corner. */
+  double             y = 0.0;
+  double             width = 0.0;
+  double             height = 0.0;
+  std::array<int, 4> color = {255, 255, 255, 255}; /**< RGBA. */
+
+  bool operator==(const GroupRecord &) const = default;
+};
+
+/**
+ * @struct GraphRecord
+ * @brief Serialized state of a whole GraphViewer.
+ */
+struct GraphRecord
+{
+  std::string              id;
+  int                      current_link_type = 0; /**< LinkType value. */
+  std::vector<NodeRecord>  nodes;
+  std::vector<LinkRecord>  links;
+  std::vector<GroupRecord> groups;
+};
+
+// --- JSON conversion, same layout as the GraphViewer::json_to output
+
+GroupRecord    group_record_from_json(const nlohmann::json &json);
+nlohmann::json group_record_to_json(const GroupRecord &record);
+GraphRecord    graph_record_from_json(const nlohmann::json &json);
+nlohmann::json graph_record_to_json(const GraphRecord &record);
+LinkRecord     link_record_from_json(const nlohmann::json &json);
+nlohmann::json link_record_to_json(const LinkRecord &record);
+NodeRecord     node_record_from_json(const nlohmann::json &json);
+nlohmann::json node_record_to_json(const NodeRecord &record);
+
+// JSON text of graph_record_to_json, except that the nodes are written
+// before the links (nlohmann sorts the keys): a streaming reader gets
+// the nodes of a link before the link (see read_graph_json_sax)
+std::string graph_record_dump(const GraphRecord &record);
+
+// --- item order
+
+// serialization order of the links, by their ends
+bool is_link_record_before(const LinkRecord &a, const LinkRecord &b);
+
+// sorts the nodes by id and the links with is_link_record_before, the
+// order written by all the serializers (the viewer registry order
+// changes with the removals)
+void sort_graph_record(GraphRecord &record);
+
+} // namespace gngui
@@ -10,21 +10,46 @@
  * GNU General Public License. See the file LICENSE for the full license.
  */
 #pragma once
+#include <deque>
 #include <functional>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
 
+#include <QFile>
 #include <QGraphicsItem>
+#include <QGraphicsScene>
 #include <QGraphicsView>
 #include <QJsonObject>
+#include <QTimer>
 
 #include "nlohmann/json.hpp"
 
+#include "gnodegui/autosave_worker.hpp"
+#include "gnodegui/graph_binary.hpp"
+#include "gnodegui/graph_patch.hpp"
+#include "gnodegui/graph_record.hpp"
 #include "gnodegui/graphics_link.hpp"
+#include "gnodegui/graphics_link_batch.hpp"
 #include "gnodegui/graphics_node.hpp"
 #include "gnodegui/node_proxy.hpp"
 
 namespace gngui
 {
 
+class GraphicsGroup;
+
+// graph items painted and culled during a frame
+struct RenderStats
+{
+  int painted_nodes = 0;
+  int painted_links = 0;
+  int culled_nodes = 0; // including the nodes not materialized yet
+  int culled_links = 0;
+};
+
 class GraphViewer : public QGraphicsView
 {
   Q_OBJECT
@@ -39,41 +64,174 @@ public:
                        QPointF            scene_pos,
                        const std::string &node_id = "");
 
+  // item at a fixed position in the viewport (in pixels), not part of
+  // the graph scene
   void add_static_item(QGraphicsItem *item, QPoint window_pos);
 
   void add_toolbar(QPoint window_pos);
 
+  // applies a delta (see graph_diff) to the current graph, only the
+  // items concerned are created, modified or deleted
+  void apply_patch(const GraphPatch &patch);
+
+  // bulk edition: scene indexing and viewport updates are suspended
+  // between begin and end (calls can be nested), the index is rebuilt
+  // and the viewport repainted once at the end
+  void begin_batch_update();
+
+  // compact binary form of json_from/json_to, see graph_binary.hpp,
+  // throws std::runtime_error if the buffer is invalid
+  void binary_from(std::string_view   buffer,
+                   bool               clear_existing_content = true,
+                   const std::string &prefix_id = "");
+
+  std::string binary_to() const;
+
   void clear();
 
+  void end_batch_update();
+
   // useful for debugging graph actual state, after export: to convert, command line: dot
   // export.dot -Tsvg > output.svg
   void export_to_graphviz(const std::string &fname = "export.dot");
 
   std::string get_id() const { return this->id; }
 
+  // a node not materialized yet (see set_lazy_node_materialization) is
+  // created on demand
   GraphicsNode *get_graphics_node_by_id(const std::string &id);
 
+  const std::vector<GraphicsGroup *> &get_graphics_groups() const { return this->groups; }
+
+  const std::vector<GraphicsLink *> &get_graphics_links() const { return this->links; }
+
+  // links connected to a given node
+  const std::vector<GraphicsLink *> &get_graphics_links_by_node_id(
+      const std::string &id) const;
+
+  const std::vector<GraphicsNode *> &get_graphics_nodes() const { return this->nodes; }
+
+  // graph items of the last frame painted (counted by their own paint
+  // calls) or skipped (culled), only counted if
+  // Style::Viewer::show_render_stats is on
+  const RenderStats &get_render_stats() const { return this->render_stats; }
+
   std::vector<std::string> get_selected_node_ids();
 
   // prefix_id can be usefull when importing a graph into an existing
   // one, to avoid duplicate node ids
-  void json_from(nlohmann::json     json,
+  void json_from(const nlohmann::json &json,
+                 bool                  clear_existing_content = true,
+                 const std::string    &prefix_id = "");
+
+  // streaming version, the records are created as they are read and
+  // the document tree is never built, throws std::runtime_error on
+  // invalid input. Only one record is held at a time if the nodes come
+  // before the links (as written by the viewer, see graph_record_dump),
+  // otherwise the links are kept until the nodes have been read
+  void json_from(std::istream      &is,
                  bool               clear_existing_content = true,
                  const std::string &prefix_id = "");
 
+  void json_from_file(const std::string &fname,
+                      bool               clear_existing_content = true,
+                      const std::string &prefix_id = "");
+
   nlohmann::json json_to() const;
 
+  // same text as graph_record_dump(record_to()), but only the items
+  // modified since the previous call are serialized again, the others
+  // are taken from a cache
+  std::string json_dump_incremental();
+
+  // loads a graph file whatever its format: plain JSON, binary (see
+  // graph_binary.hpp) or compressed (see graph_compression.hpp), throws
+  // std::runtime_error
+  void load_file(const std::string &fname,
+                 bool               clear_existing_content = true,
+                 const std::string &prefix_id = "");
+
+  // opens a graph file (binary, JSON or compressed) through a read-only
+  // memory mapping, the records are read in place and the nodes are
+  // materialized once visible (see set_lazy_node_materialization),
+  // throws std::runtime_error
+  void load_mapped(const std::string &fname);
+
+  // loads a file written by save_full and replays its journal
+  // 'fname.journal' (see save_journal), unless the journal has been
+  // written for another version of the file, throws std::runtime_error
+  void load_with_journal(const std::string &fname);
+
+  // creates all the nodes still pending from a lazy import
+  void materialize_all_nodes();
+
+  // inserts a buffer from selection_to_binary in the current graph,
+  // node ids are prefixed as with json_from and positions are shifted
+  // by 'delta', the pasted nodes are selected. Throws
+  // std::runtime_error if the buffer is invalid
+  void paste_binary(std::string_view   buffer,
+                    const std::string &prefix_id,
+                    QPointF            delta = QPointF(0.f, 0.f));
+
+  // graph state as plain records, used by the JSON and binary
+  // serializers
+  void record_from(const GraphRecord &record,
+                   bool               clear_existing_content = true,
+                   const std::string &prefix_id = "");
+
+  GraphRecord record_to() const;
+
+  // brings the graph to the state of 'record' by applying the
+  // difference with the current state, instead of a clear and a full
+  // reload (see apply_patch)
+  void record_update(const GraphRecord &record);
+
   void remove_node(const std::string &node_id);
 
+  // writes the graph compressed (see graph_compression.hpp), in JSON or
+  // in the binary format, 'level' from 0 to 9 (-1 for the default),
+  // throws std::runtime_error
+  void save_compressed(const std::string &fname, bool binary = false, int level = -1);
+
+  // writes the whole graph in JSON to 'fname' and empties the journal
+  // 'fname.journal', whose first line is then a stamp (hash) of the new
+  // file, throws std::runtime_error
+  void save_full(const std::string &fname);
+
+  // appends to 'fname.journal' a single line patch (see graph_patch.hpp)
+  // with the changes since the previous save_full or save_journal,
+  // does a save_full if none has been done yet
+  void save_journal(const std::string &fname);
+
   void save_screenshot(const std::string &fname = "screenshot.png");
 
+  // selected nodes, the links between them and the groups they enclose,
+  // in the binary format (see graph_binary.hpp), for copy/paste
+  std::string selection_to_binary() const;
+
   void set_id(const std::string &new_id) { this->id = new_id; }
 
+  // when enabled, the imported nodes are only kept as records
+  // (placeholders) and the actual nodes are created once they get
+  // close to the visible area, or when they are queried. Disabling it
+  // creates all the pending nodes
+  void set_lazy_node_materialization(bool new_state);
+
   void set_node_inventory(const std::map<std::string, std::string> &new_node_inventory)
   {
     this->node_inventory = new_node_inventory;
   }
 
+  // periodic autosave in the binary format (see graph_binary.hpp): a
+  // snapshot of the graph is taken on the GUI thread every
+  // 'interval_ms' and written to disk by a worker thread, compressed
+  // there if 'compress' is set (see graph_compression.hpp)
+  void start_autosave(const std::string &fname,
+                      int                interval_ms = 60000,
+                      bool               compress = false);
+
+  void stop_autosave();
+
   void toggle_link_type();
 
   void zoom_to_content();
@@ -161,8 +319,6 @@ protected: // Qt events
 
   void delete_selected_items();
 
-  void drawForeground(QPainter *painter, const QRectF &rect) override;
-
   void keyPressEvent(QKeyEvent *event) override;
 
   void keyReleaseEvent(QKeyEvent *event) override;
@@ -173,6 +329,8 @@ protected: // Qt events
 
   void mouseReleaseEvent(QMouseEvent *event) override;
 
+  void paintEvent(QPaintEvent *event) override;
+
   void resizeEvent(QResizeEvent *event) override;
 
   void wheelEvent(QWheelEvent *event) override;
@@ -191,24 +349,182 @@ private Q_SLOTS:
 private:
   std::string id;
 
-  std::vector<QGraphicsItem *> static_items;
-  std::vector<QPoint>          static_items_positions;
+  // overlay holding the static items (toolbar), see add_static_item
+  QGraphicsView *overlay_view = nullptr;
 
   // all nodes available store as a map of (node type, node category)
   std::map<std::string, std::string> node_inventory;
 
+  // connection-drag state: the link being dragged, the node and port it
+  // starts from, and the node currently hovered by the cursor
   GraphicsLink *temp_link = nullptr;   // Temporary link
   GraphicsNode *source_node = nullptr; // Source node for the connection
+  int           source_port_index = -1;
+  GraphicsNode *target_node = nullptr;
 
   LinkType current_link_type = LinkType::CUBIC;
 
+  // draws the batched links (see Style::Link::batched_rendering), spans
+  // the scene rect and is not part of the graph (not registered)
+  GraphicsLinkBatch *link_batch = nullptr;
+
+  // nesting level of begin_batch_update, and index method to restore
+  int                             batch_update_depth = 0;
+  QGraphicsScene::ItemIndexMethod batch_index_method = QGraphicsScene::BspTreeIndex;
+
+  // large selection being dragged, the scene index is dropped meanwhile
+  bool                            is_bulk_moving = false;
+  QGraphicsScene::ItemIndexMethod bulk_move_index_method = QGraphicsScene::BspTreeIndex;
+
+  RenderStats render_stats;
+
+  // registry of the graph items, kept in sync on add/delete so that
+  // lookups and type-specific traversals do not scan the whole scene
+  // (the links connected to a node are stored by the node itself), the
+  // slots (index in 'nodes' and 'links') allow O(1) swap-and-pop removal
+  // so the vectors are not in insertion order
+  std::unordered_map<std::string, GraphicsNode *> nodes_by_id;
+  std::vector<GraphicsNode *>                     nodes;
+  std::unordered_map<GraphicsNode *, size_t>      node_slots;
+  std::vector<GraphicsLink *>                     links;
+  std::unordered_map<GraphicsLink *, size_t>      link_slots;
+  std::vector<GraphicsGroup *>                    groups;
+
+  // incremental serialization, see json_dump_incremental: JSON text of
+  // each item when last serialized, and changes not yet written to the
+  // journal (only recorded once a save_full has been done)
+  std::unordered_map<GraphicsNode *, std::string> node_fragments;
+  std::unordered_map<GraphicsLink *, std::string> link_fragments;
+  std::string                                     groups_fragment = "[]";
+  bool                                            are_groups_dirty = true;
+  int                                             serialized_link_type = -1;
+  bool                                            is_journal_enabled = false;
+  GraphPatch                                      journal_patch;
+
+  // lazy node materialization: records of the nodes not created yet
+  // (by prefixed id) binned on a coarse scene grid, and the links
+  // waiting for one of their nodes (indices in 'pending_links' by node
+  // id, emptied entries once created). The records are views on the
+  // memory mapping of load_mapped (or its inflated content), or on
+  // copies of the imported strings, all released with the last
+  // placeholder (see release_placeholders)
+  bool    is_lazy_materialization = false;
+  QTimer *materialization_timer = nullptr;
+
+  std::unordered_map<std::string_view, NodeRecordView>       node_placeholders;
+  std::unordered_map<int64_t, std::vector<std::string_view>> placeholder_grid;
+  std::vector<std::optional<LinkRecordView>>                 pending_links;
+  std::unordered_map<std::string_view, std::vector<size_t>>  pending_links_by_node;
+  std::unique_ptr<QFile>                                     placeholder_file;
+  std::unique_ptr<std::string>                               placeholder_buffer;
+  std::deque<std::string>                                    placeholder_strings;
+
+  // autosave
+  std::string                     autosave_fname;
+  bool                            is_autosave_compressed = false;
+  QTimer                         *autosave_timer = nullptr;
+  std::unique_ptr<AutosaveWorker> autosave_worker;
+
+  void add_group_record(const GroupRecord &record);
+
+  // takes a snapshot of the graph and hands it to the autosave worker
+  void autosave();
+
+  // creates a link between two ports without going through the
+  // interactive connection (no temporary link), returns nullptr if the
+  // ports cannot be connected
+  GraphicsLink *add_link(GraphicsNode *from_node,
+                         int           port_from_index,
+                         GraphicsNode *to_node,
+                         int           port_to_index);
+
+  void add_link_record(const LinkRecord &record, const std::string &prefix_id);
+
+  void add_node_placeholder(const NodeRecord &record, const std::string &prefix_id);
+
+  void add_node_placeholder(const NodeRecordView &placeholder);
+
+  void add_node_record(const NodeRecord &record, const std::string &prefix_id);
+
+  void add_pending_link(const LinkRecordView &record);
+
+  // serializes the new and dirty items, and records the changes in the
+  // journal patch
+  void collect_changes();
+
   void delete_graphics_link(GraphicsLink *p_link);
 
   void delete_graphics_node(GraphicsNode *p_node);
 
-  bool is_item_static(QGraphicsItem *item);
+  // registry lookup, never materializes a placeholder
+  GraphicsNode *find_node(const std::string &id) const;
+
+  // scene itemsBoundingRect without the link batch item (which spans
+  // the scene rect)
+  QRectF get_items_bounding_rect() const;
+
+  QRectF get_placeholder_rect(const NodeRecordView &record) const;
+
+  // enlarges the scene rect (never shrinks it) to hold 'rect' with some
+  // room around
+  void grow_scene_rect(const QRectF &rect);
+
+  void get_selected_nodes_positions(std::vector<std::string> &id_list,
+                                    std::vector<QPointF>     &scene_pos_list);
+
+  // node or link of an imported graph, held back as a placeholder or a
+  // pending link when lazy materialization is on
+  void import_link_record(const LinkRecord &record, const std::string &prefix_id);
+
+  void import_node_record(const NodeRecord &record, const std::string &prefix_id);
+
+  void journal_link_removed(GraphicsLink *p_link);
+
+  void journal_node_removed(GraphicsNode *p_node);
+
+  // creates the node of a placeholder and its pending links, returns
+  // nullptr if 'id' is not a placeholder
+  GraphicsNode *materialize_node(const std::string &id);
+
+  void materialize_visible_nodes();
+
+  // record_to in the registry order, the sort is left to the caller (the
+  // autosave worker sorts on its own thread)
+  GraphRecord record_to_unsorted() const;
+
+  void register_item(QGraphicsItem *item);
+
+  // drops the placeholders, the pending links and the storage of their
+  // strings
+  void release_placeholders();
+
+  void register_link(GraphicsLink *p_link);
+
+  // deletes the link matching the record ends, if any
+  void remove_link_record(const LinkRecord &record);
+
+  void reset_connection_drag();
+
+  void reset_serialization_cache();
+
+  // coalesced materialize_visible_nodes once the view has settled
+  void schedule_materialization();
+
+  // BSP depth set from the number of items, see Style::Viewer::bsp_tree_depth
+  void tune_scene_index();
 
   void select_all();
+
+  // copy owned by the placeholders storage, valid until
+  // release_placeholders
+  std::string_view store_placeholder_string(std::string &&string);
+
+  void unregister_item(QGraphicsItem *item);
+
+  void unregister_link(GraphicsLink *p_link);
+
+  // hit-test the node under the cursor while a link is being dragged
+  void update_connection_target(QPointF scene_pos);
 };
 
 } // namespace gngui
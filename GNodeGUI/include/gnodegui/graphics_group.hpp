@@ -18,24 +18,37 @@
 #include <QGraphicsRectItem>
 #include <QGraphicsSceneMouseEvent>
 
+#include "gnodegui/graph_record.hpp"
 #include "gnodegui/logger.hpp"
 
 namespace gngui
 {
 
+class GraphicsLink;
+
 class GraphicsGroup : public QGraphicsRectItem
 {
 public:
   GraphicsGroup(QGraphicsItem *parent = nullptr);
 
+  // true if the serialized state (position, size, caption, color)
+  // changed since the flag was last reset
+  bool get_is_dirty() const { return this->is_dirty; }
+
   void json_from(nlohmann::json json);
 
   nlohmann::json json_to() const;
 
+  void record_from(const GroupRecord &record);
+
+  GroupRecord record_to() const;
+
   void set_caption(const std::string &new_caption);
 
   void set_color(const QColor &new_color);
 
+  void set_is_dirty(bool new_state) { this->is_dirty = new_state; }
+
 protected:
   enum Corner
   {
@@ -48,6 +61,8 @@ protected:
 
   void contextMenuEvent(QGraphicsSceneContextMenuEvent *event) override;
 
+  QVariant itemChange(GraphicsItemChange change, const QVariant &value) override;
+
   void hoverEnterEvent(QGraphicsSceneHoverEvent *event) override;
 
   void hoverLeaveEvent(QGraphicsSceneHoverEvent *event) override;
@@ -71,14 +86,16 @@ private:
   QColor             color;
 
   bool is_hovered = false;
+  bool is_dirty = true;
 
   bool    resizing;
   QPointF resize_start_pos;
   qreal   resize_handle_size; // Size of the corner area for resizing
 
-  bool                   dragging;
-  QPointF                drag_start_pos;
-  QList<QGraphicsItem *> selected_items;
+  bool                        dragging;
+  QPointF                     drag_start_pos;
+  QList<QGraphicsItem *>      selected_items;
+  std::vector<GraphicsLink *> dragged_links; // links updated once per move
 
   // Helper function to determine which corner is being hovered or clicked
   Corner get_resize_corner(const QPointF &pos) const;
@@ -19,6 +19,7 @@
 
 #include "nlohmann/json.hpp"
 
+#include "gnodegui/graph_record.hpp"
 #include "gnodegui/graphics_node.hpp"
 
 namespace gngui
@@ -63,12 +64,24 @@ public:
                LinkType       link_type = LinkType::CUBIC,
                QGraphicsItem *parent = nullptr);
 
+  /**
+   * @brief Destructor, drops the pending repaint requests of the link.
+   */
+  ~GraphicsLink() override;
+
+  /**
+   * @brief Gets the color of the link.
+   *
+   * @return The link color.
+   */
+  QColor get_color() const { return this->color; }
+
   /**
    * @brief Gets the output node connected by this link.
    *
    * @return Pointer to the output GraphicsNode.
    */
-  GraphicsNode *get_node_out() { return this->node_out; }
+  GraphicsNode *get_node_out() const { return this->node_out; }
 
   /**
    * @brief Gets the index of the output port.
@@ -82,7 +95,7 @@ public:
    *
    * @return Pointer to the input GraphicsNode.
    */
-  GraphicsNode *get_node_in() { return this->node_in; }
+  GraphicsNode *get_node_in() const { return this->node_in; }
 
   /**
    * @brief Gets the index of the input port.
@@ -91,6 +104,32 @@ public:
    */
   int get_port_in_index() const { return this->port_in_index; }
 
+  /**
+   * @brief Gets the pen style of the link.
+   *
+   * @return The pen style.
+   */
+  Qt::PenStyle get_pen_style() const { return this->pen_style; }
+
+  /**
+   * @brief Returns the number of links painted by their own paint since the last
+   * reset_paint_count (all links), used for the viewer render stats.
+   *
+   * @return The number of paint calls that drew a link.
+   */
+  static int get_paint_count() { return GraphicsLink::paint_count; }
+
+  /**
+   * @brief Checks whether the link is currently drawn by the GraphicsLinkBatch item
+   * (batched, not selected and not hovered) rather than by its own paint.
+   *
+   * @return True if the link does not paint itself.
+   */
+  bool is_batch_painted() const
+  {
+    return this->is_batched && !this->isSelected() && !this->is_link_hovered;
+  }
+
   /**
    * @brief Serializes the link to a JSON object.
    *
@@ -98,6 +137,18 @@ public:
    */
   nlohmann::json json_to() const;
 
+  /**
+   * @brief Serializes the link to a record (see graph_record.hpp).
+   *
+   * @return A record of the link.
+   */
+  LinkRecord record_to() const;
+
+  /**
+   * @brief Resets the paint calls counter, see get_paint_count().
+   */
+  static void reset_paint_count() { GraphicsLink::paint_count = 0; }
+
   /**
    * @brief Sets the nodes and ports that this link connects.
    *
@@ -119,6 +170,14 @@ public:
    */
   void set_endpoints(const QPointF &start_point, const QPointF &end_point);
 
+  /**
+   * @brief Sets whether the link is drawn by the GraphicsLinkBatch item (see
+   * Style::Link::batched_rendering), the item then only handles the interaction.
+   *
+   * @param new_state The new state.
+   */
+  void set_is_batched(bool new_state);
+
   /**
    * @brief Sets the link type.
    *
@@ -143,6 +202,14 @@ public:
    */
   LinkType toggle_link_type();
 
+  /**
+   * @brief Recomputes the link path from the current positions of its end nodes.
+   *
+   * Called only when an end node moves or changes its geometry, the link path is then
+   * cached and simply drawn when the link is painted.
+   */
+  void update_path();
+
 protected:
   /**
    * @brief Provides the bounding rectangle for the link, accounting for additional
@@ -152,6 +219,16 @@ protected:
    */
   QRectF boundingRect() const override;
 
+  /**
+   * @brief Checks whether a point is close enough to the link to hit it, using the
+   * distance to a polyline approximation of the path (much cheaper than checking the
+   * stroked shape).
+   *
+   * @param point The point to test, in item coordinates.
+   * @return True if the point hits the link.
+   */
+  bool contains(const QPointF &point) const override;
+
   /**
    * @brief Handles the hover enter event when the mouse hovers over the link.
    *
@@ -190,6 +267,13 @@ private:
   Qt::PenStyle pen_style = Qt::DashLine; ///< The pen style of the link.
 
   bool is_link_hovered = false; ///< Flag to track if the link is being hovered.
+  bool is_batched = false;      ///< Flag to track if the link is drawn by the viewer.
+
+  static inline int paint_count = 0; ///< Paint calls, see get_paint_count.
+
+  std::vector<QPointF> hit_polyline;                ///< Polyline approx. of the path.
+  mutable QPainterPath shape_cache;                 ///< Clickable shape, built on demand.
+  mutable bool         is_shape_cache_dirty = true; ///< Flag to rebuild the shape.
 
   /**
    * @brief List of available link types.
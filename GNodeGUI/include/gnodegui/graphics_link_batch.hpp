@@ -0,0 +1,62 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+
+/**
+ * @file graphics_link_batch.hpp
+ * @author Otto Link (otto.link.bv@gmail.com)
+ * @brief Defines the GraphicsLinkBatch class, drawing the batched links of a scene
+ * (see Style::Link::batched_rendering).
+ * @copyright Copyright (c) 2024 Otto Link. Distributed under the terms of the
+ * GNU General Public License. See the file LICENSE for the full license.
+ */
+#pragma once
+#include <QGraphicsItem>
+#include <QPainterPath>
+
+namespace gngui
+{
+
+/**
+ * @class GraphicsLinkBatch
+ * @brief Scene item painting all the links flagged as batched (see
+ * GraphicsLink::is_batch_painted), with one stroke per color and pen style instead
+ * of one paint call per link.
+ *
+ * The item sits at the links z value, so the batched links keep the stacking of the
+ * per-item links (above the groups, below the nodes). It covers the whole scene rect
+ * but has an empty shape: it is never hit by the mouse or by shape-based queries.
+ * Only the links intersecting the exposed rect are drawn, found with the scene index.
+ */
+class GraphicsLinkBatch : public QGraphicsItem
+{
+public:
+  GraphicsLinkBatch(QGraphicsItem *parent = nullptr);
+
+  QRectF boundingRect() const override { return this->bbox; }
+
+  /**
+   * @brief Returns the number of links drawn since the last reset_paint_count, used
+   * for the viewer render stats.
+   */
+  int get_paint_count() const { return this->paint_count; }
+
+  void paint(QPainter                       *painter,
+             const QStyleOptionGraphicsItem *option,
+             QWidget                        *widget = nullptr) override;
+
+  void reset_paint_count() { this->paint_count = 0; }
+
+  /**
+   * @brief Sets the area covered by the item, the scene rect.
+   */
+  void set_bounding_rect(const QRectF &new_bbox);
+
+  QPainterPath shape() const override { return QPainterPath(); }
+
+private:
+  QRectF bbox;
+  int    paint_count = 0;
+};
+
+} // namespace gngui
@@ -11,6 +11,7 @@
  */
 #pragma once
 #include <memory>
+#include <unordered_map>
 
 #include <QEvent>
 #include <QGraphicsRectItem>
@@ -20,6 +21,7 @@
 
 #include "nlohmann/json.hpp"
 
+#include "gnodegui/graph_record.hpp"
 #include "gnodegui/graphics_link.hpp"
 #include "gnodegui/graphics_node_geometry.hpp"
 #include "gnodegui/logger.hpp"
@@ -52,6 +54,17 @@ public:
    */
   GraphicsNode(NodeProxy *p_node_proxy, QGraphicsItem *parent = nullptr);
 
+  /**
+   * @brief Destructor, drops the pending repaint requests of the node.
+   */
+  ~GraphicsNode() override;
+
+  /**
+   * @brief Adds a link to the list of links connected to the node ports.
+   * @param p_link Pointer to the link.
+   */
+  void add_connected_link(GraphicsLink *p_link);
+
   /**
    * @brief Retrieves the node's caption.
    * @return The caption of the node.
@@ -71,14 +84,35 @@ public:
    */
   std::vector<std::string> get_category_splitted(char delimiter = '/') const;
 
+  /**
+   * @brief Retrieves all the links connected to the node, including all the links
+   * fanning out of each output port.
+   * @return Reference to the list of connected links.
+   */
+  const std::vector<GraphicsLink *> &get_connected_links() const
+  {
+    return this->connected_links;
+  }
+
   /**
    * @brief Retrieves the data type of a specific port by index.
    * @param port_index Index of the port.
    * @return Data type as a string.
    */
-  std::string get_data_type(int port_index) const
+  const std::string &get_data_type(int port_index) const
   {
-    return this->p_node_proxy->get_data_type(port_index);
+    return this->ports[port_index].data_type;
+  }
+
+  /**
+   * @brief Retrieves the interned id of the data type of a specific port (see
+   * intern_data_type), resolved once at the node creation.
+   * @param port_index Index of the port.
+   * @return Data type id.
+   */
+  int get_data_type_id(int port_index) const
+  {
+    return this->ports[port_index].data_type_id;
   }
 
   /**
@@ -87,6 +121,13 @@ public:
    */
   GraphicsNodeGeometry *get_geometry_ref() { return &(this->geometry); };
 
+  /**
+   * @brief Returns true if the serialized state of the node (position, widget
+   * visibility) changed since the flag was last reset.
+   * @return Dirty state.
+   */
+  bool get_is_dirty() const { return this->is_dirty; }
+
   /**
    * @brief Provides a reference to the node's geometry object.
    * @return Reference to GraphicsNodeGeometry.
@@ -103,32 +144,39 @@ public:
    * @brief Provides a reference to the node's geometry object.
    * @return Reference to GraphicsNodeGeometry.
    */
-  int get_nports() const { return this->p_node_proxy->get_nports(); }
+  int get_nports() const { return static_cast<int>(this->ports.size()); }
+
+  /**
+   * @brief Returns the number of node paint calls since the last reset_paint_count
+   * (all nodes), used for the viewer render stats.
+   */
+  static int get_paint_count() { return GraphicsNode::paint_count; }
 
   /**
    * @brief Provides a reference to the node's geometry object.
    * @return Reference to GraphicsNodeGeometry.
    */
-  std::string get_port_caption(int port_index) const
+  const std::string &get_port_caption(int port_index) const
   {
-    return this->p_node_proxy->get_port_caption(port_index);
+    return this->ports[port_index].caption;
   }
 
   /**
    * @brief Provides a reference to the node's geometry object.
    * @return Reference to GraphicsNodeGeometry.
    */
-  std::string get_port_id(int port_index) const
+  const std::string &get_port_id(int port_index) const
   {
-    return this->p_node_proxy->get_port_id(port_index);
+    return this->ports[port_index].id;
   }
 
   /**
    * @brief Retrieves the index of the port corresponding to the given identifier.
    *
-   * This function searches for the port that matches the provided string identifier and
-   * returns its index. If the identifier does not match any existing ports, it may return
-   * a sentinel value (e.g., -1).
+   * This function looks up the port that matches the provided string identifier in a
+   * hashed index built with the port descriptors (constant time) and returns its index.
+   * If the identifier does not match any existing ports, it returns -1. If several
+   * ports share the same identifier, the first one is returned.
    *
    * @param id The string identifier of the port.
    * @return int The index of the port, or a sentinel value if the port is not found.
@@ -139,10 +187,7 @@ public:
    * @brief Provides a reference to the node's geometry object.
    * @return Reference to GraphicsNodeGeometry.
    */
-  PortType get_port_type(int port_index) const
-  {
-    return this->p_node_proxy->get_port_type(port_index);
-  }
+  PortType get_port_type(int port_index) const { return this->ports[port_index].type; }
 
   /**
    * @brief Provides a reference to the node's geometry object.
@@ -176,21 +221,98 @@ public:
   nlohmann::json json_to() const;
 
   /**
-   * @brief Loads node data from a JSON object (is set to nullptr to flag a disconnect
-   * port).
-   * @param json JSON object containing node data.
+   * @brief Loads node data from a record (see graph_record.hpp).
+   * @param record Node record.
+   */
+  void record_from(const NodeRecord &record);
+
+  /**
+   * @brief Saves node data to a record (see graph_record.hpp).
+   * @return Node record.
+   */
+  NodeRecord record_to() const;
+
+  /**
+   * @brief Resets all port hover states to false.
+   */
+  void reset_is_port_hovered();
+
+  /**
+   * @brief Resets the paint calls counter, see get_paint_count().
+   */
+  static void reset_paint_count() { GraphicsNode::paint_count = 0; }
+
+  /**
+   * @brief Resets the port hover state and the data type of the link being dragged,
+   * called once a connection attempt is over.
+   */
+  void reset_connection_state();
+
+  /**
+   * @brief Enables or disables the update of the connected links when the node moves.
+   * Disabled when many nodes are moved at once, so that the caller can update each
+   * link only once.
+   * @param new_state True to update the links on each move.
    */
-  void set_is_port_connected(int port_index, GraphicsLink *p_link)
+  void set_connected_links_update(bool new_state)
   {
-    this->connected_link_ref[port_index] = p_link;
+    this->is_connected_links_update_enabled = new_state;
   }
 
+  /**
+   * @brief Sets or resets the serialization dirty flag, see get_is_dirty().
+   * @param new_state New state.
+   */
+  void set_is_dirty(bool new_state) { this->is_dirty = new_state; }
+
+  /**
+   * @brief Sets the data type id of the link currently being dragged in the scene (-1 if
+   * none), used to dim the ports which cannot accept it.
+   * @param new_data_type_id Data type id of the port the link is dragged from.
+   */
+  void set_data_type_connecting(int new_data_type_id);
+
+  /**
+   * @brief Reloads the port descriptors and the caption from the NodeProxy and rebuilds
+   * the node geometry. The port metadata are only read from the proxy at the node
+   * creation and when this method is called, it must be called if the proxy changes its
+   * ports or its caption (the links connected to removed ports must be deleted
+   * beforehand).
+   */
+  void refresh_ports();
+
+  /**
+   * @brief Removes a link from the list of links connected to the node ports.
+   * @param p_link Pointer to the link.
+   */
+  void remove_connected_link(GraphicsLink *p_link);
+
+  /**
+   * @brief Requests a repaint of the node only if its visual state (selected, hovered,
+   * computing, hovered port, connecting data type) changed since the last repaint,
+   * to preserve the node render cache. If only the hovered port changed, only the
+   * concerned ports are repainted (see schedule_item_update).
+   */
+  void update_render_state();
+
   /**
    * @brief Sets the visibility of the associated QWidget.
    * @param visible True to make visible, false to hide.
    */
   void set_qwidget_visibility(bool is_visible);
 
+  /**
+   * @brief Updates the port hover state while a link is dragged from another node. Only
+   * the ports compatible with the dragged port (opposite port type and same data type)
+   * can be flagged as hovered.
+   * @param scene_pos The current mouse position in the scene.
+   * @param from The node the link is dragged from.
+   * @param port_index_from Index of the port the link is dragged from.
+   */
+  void update_connection_hover(QPointF       scene_pos,
+                               GraphicsNode *from,
+                               int           port_index_from);
+
 public Q_SLOTS:
   /**
    * @brief Slot called when node computation is finished.
@@ -310,28 +432,61 @@ protected:
                      const QStyleOptionGraphicsItem *option,
                      QWidget                        *widget) override;
 
+private:
   /**
-   * @brief Filters events occurring on the scene that the node observes.
-   * @param watched Item being watched.
-   * @param event Event details.
-   * @return True if the event is handled, otherwise false.
+   * @struct PortDescriptor
+   * @brief Port metadata copied from the NodeProxy, to keep the virtual calls (and
+   * their string allocations) out of the painting and hovering paths.
    */
-  bool sceneEventFilter(QGraphicsItem *watched, QEvent *event) override;
+  struct PortDescriptor
+  {
+    std::string id;
+    std::string caption;
+    QString     label; /**< Caption as painted. */
+    std::string data_type;
+    int         data_type_id; /**< Interned data type, see intern_data_type. */
+    PortType    type;
+  };
+
+  /**
+   * @struct RenderState
+   * @brief Visual state of the node, the render cache is only invalidated when it
+   * changes.
+   */
+  struct RenderState
+  {
+    bool is_selected = false;
+    bool is_hovered = false;
+    bool is_computing = false;
+    int  hovered_port_index = -1;
+    int  data_type_id_connecting = -1;
+
+    bool operator==(const RenderState &) const = default;
+  };
+
+  static inline int paint_count = 0; /**< Paint calls, see get_paint_count. */
 
-private:
   NodeProxy           *p_node_proxy; /**< Pointer to the associated NodeProxy instance. */
   GraphicsNodeGeometry geometry;     /**< Geometry data for the node. */
   bool is_node_dragged = false; /**< Indicates if the node is currently being dragged. */
   bool is_node_hovered = false; /**< Indicates if the mouse is hovering over the node. */
   std::vector<bool> is_port_hovered; /**< Flags for each port's hover state. */
   std::vector<GraphicsLink *>
-       connected_link_ref;        /**< References to links connected to this node. */
+       connected_links;           /**< References to links connected to this node. */
   bool is_node_computing = false; /**< Indicates if the node is currently computing. */
   bool is_widget_visible = true;  /**< Indicates if the associated widget is visible. */
+  bool is_dirty = true;           /**< Indicates if the serialized state changed. */
+  bool is_connected_links_update_enabled = true; /**< Indicates if the connected links
+                                                    follow the node moves. */
   bool has_connection_started = false; /**< Tracks if a connection attempt has started. */
   int  port_index_from;                /**< Index of the port initiating a connection. */
-  std::string data_type_connecting = ""; /**< Data type of the port currently attempting a
-                                            connection. */
+  int  data_type_id_connecting = -1; /**< Data type id of the port currently attempting
+                                        a connection. */
+  int  category_id;                  /**< Interned main category. */
+  std::vector<PortDescriptor> ports; /**< Port metadata, see refresh_ports. */
+  QString caption_label;             /**< Node caption as painted, see refresh_ports. */
+  std::unordered_map<std::string, int> port_index_by_id; /**< Port id to port index. */
+  RenderState render_state; /**< Visual state of the last requested repaint. */
 
   /**
    * @brief Retrieves the index of the port currently hovered by the mouse.
@@ -339,6 +494,17 @@ private:
    */
   int get_hovered_port_index() const;
 
+  /**
+   * @brief Fills the port descriptors table and the caption label from the NodeProxy.
+   */
+  void load_ports();
+
+  /**
+   * @brief Updates the links connected to the node after a change of the node position
+   * or geometry.
+   */
+  void update_connected_links();
+
   /**
    * @brief Updates the geometry of the node based on the specified widget size.
    * @param widget_size Optional new widget size; default is (-1, -1) for no change.
@@ -351,11 +517,6 @@ private:
    * @return True if any port hover state changed, otherwise false.
    */
   bool update_is_port_hovered(QPointF scene_pos);
-
-  /**
-   * @brief Resets all port hover states to false.
-   */
-  void reset_is_port_hovered();
 };
 
 } // namespace gngui
@@ -19,6 +19,7 @@
 
 #pragma once
 #include <QGraphicsPathItem>
+#include <QPainterPath>
 
 namespace gngui
 {
@@ -46,6 +47,13 @@ public:
    */
   AbstractIcon(float width, QColor color, float pen_width, QGraphicsItem *parent);
 
+  /**
+   * @brief Returns the bounding rectangle of the icon, including its drop shadow.
+   *
+   * @return The bounding rectangle.
+   */
+  QRectF boundingRect() const override;
+
   /**
    * @brief Sets the opacity of the icon's pen.
    *
@@ -107,6 +115,27 @@ protected:
    */
   void mouseReleaseEvent(QGraphicsSceneMouseEvent *event) override;
 
+  /**
+   * @brief Paints the icon and its drop shadow (pre-rendered and shared by all the
+   * icons with the same appearance), skipped when the view is zoomed out enough for the
+   * icons to be irrelevant.
+   *
+   * @param painter The painter used for drawing the icon.
+   * @param option The style options for the item.
+   * @param widget The widget that is being painted on.
+   */
+  void paint(QPainter                       *painter,
+             const QStyleOptionGraphicsItem *option,
+             QWidget                        *widget) override;
+
+  /**
+   * @brief Sets the icon's path, to be used by `set_path` instead of `setPath` so that
+   * the shadow key follows the path.
+   *
+   * @param path The new path.
+   */
+  void set_icon_path(const QPainterPath &path);
+
   /**
    * @brief Pure virtual function to define the icon's path.
    *
@@ -114,6 +143,13 @@ protected:
    */
   virtual void set_path() = 0;
 
+  /**
+   * @brief Rebuilds the key of the icon shadow in the pixmap cache from the icon type,
+   * size, pen, brush, current path and device pixel ratio. Called when one of them
+   * changes, so that painting only does the cache lookup.
+   */
+  void update_shadow_key();
+
   /**
    * @brief The width of the icon.
    */
@@ -142,5 +178,15 @@ protected:
    * Default value is "tooltip".
    */
   QString tooltip = "tooltip";
+
+  /**
+   * @brief The key of the icon shadow in the pixmap cache, see `update_shadow_key`.
+   */
+  QString shadow_key;
+
+  /**
+   * @brief The device pixel ratio the shadow key has been built for.
+   */
+  qreal shadow_dpr = 1.0;
 };
 } // namespace gngui
\ No newline at end of file
@@ -0,0 +1,64 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+
+/**
+ * @file string_interner.hpp
+ * @author Otto Link (otto.link.bv@gmail.com)
+ * @brief Defines the StringInterner class, mapping strings to small integer ids.
+ * @copyright Copyright (c) 2024 Otto Link. Distributed under the terms of the
+ * GNU General Public License. See the file LICENSE for the full license.
+ */
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gngui
+{
+
+/**
+ * @class StringInterner
+ * @brief Assigns a stable integer id to each distinct string, so that strings used as
+ * keys in hot paths (port data types, node categories) can be compared and used as
+ * indices at integer cost.
+ */
+class StringInterner
+{
+public:
+  StringInterner() = default;
+
+  /**
+   * @brief Returns the id of the string, or -1 if it has never been interned.
+   * @param  string Input string.
+   * @return        Id.
+   */
+  int find(const std::string &string) const;
+
+  /**
+   * @brief Returns the string corresponding to an id.
+   * @param  id Id, must have been returned by intern().
+   * @return    String.
+   */
+  const std::string &get_string(int id) const { return this->strings.at(id); }
+
+  /**
+   * @brief Returns the id of the string, assigning a new one (the current table size)
+   * if the string has never been seen.
+   * @param  string Input string.
+   * @return        Id.
+   */
+  int intern(const std::string &string);
+
+  /**
+   * @brief Returns the number of interned strings, ids are in [0, size()).
+   * @return Size.
+   */
+  int size() const { return static_cast<int>(this->strings.size()); }
+
+private:
+  std::unordered_map<std::string, int> ids;     /**< String to id. */
+  std::vector<std::string>             strings; /**< Id to string. */
+};
+
+} // namespace gngui
@@ -13,6 +13,7 @@
 #include <map>
 
 #include <QColor>
+#include <QGraphicsView>
 #include <QPoint>
 
 #define GN_STYLE gngui::Style::get_style()
@@ -40,6 +41,18 @@ public:
     bool   add_load_save_icons = true;
 
     bool disable_during_update = true;
+
+    int pixmap_cache_limit = 65536; // in kB, shared by the item render caches
+
+    int  bsp_tree_depth = 0;        // scene index depth, 0 to fit it to the graph size
+    int  bulk_move_threshold = 64;  // selection size from which dragging drops the index
+    bool show_render_stats = false; // painted/culled items counters in the viewport
+
+    // repaint policy: how Qt merges the dirty areas of a frame, and the
+    // cap on the rate of the item repaints (hover...), in Hz, 0 for none
+    QGraphicsView::ViewportUpdateMode viewport_update_mode =
+        QGraphicsView::SmartViewportUpdate;
+    int max_repaint_rate = 60;
   } viewer;
 
   struct Node
@@ -56,6 +69,13 @@ public:
 
     bool reload_button = true;
     bool settings_button = true;
+    bool render_cache = true; // device coordinate cache, off with show_render_stats
+
+    // level of detail, zoom levels below which the port labels, the
+    // caption and eventually all the details (flat rectangle) are dropped
+    float lod_port_labels = 0.6f;
+    float lod_caption = 0.4f;
+    float lod_simplified = 0.25f;
 
     QColor color_bg = QColor(102, 102, 102, 255);
     QColor color_bg_light = QColor(108, 108, 108, 255);
@@ -86,6 +106,9 @@ public:
     float  pen_width_selected = 3.f;
     float  port_tip_radius = 2.f;
     float  curvature = 0.5f;
+    float  hit_distance = 20.f;       // distance to the path to catch the mouse
+    float  lod_simplified = 0.25f;    // zoom level below which links are straight lines
+    bool   batched_rendering = false; // drawn by the viewer, one pass per color/style
     QColor color_default = Qt::lightGray;
     QColor color_selected = QColor(80, 250, 123, 255);
   } link;
@@ -127,4 +150,35 @@ private:
 
 QColor get_color_from_data_type(const std::string &data_type);
 
+/**
+ * @brief Returns the port color of an interned data type (see intern_data_type), read
+ * from a flat table indexed by the id.
+ */
+QColor get_color_from_data_type_id(int data_type_id);
+
+/**
+ * @brief Returns the header color of an interned category (see intern_category), read
+ * from a flat table indexed by the id.
+ */
+QColor get_color_from_category_id(int category_id);
+
+/**
+ * @brief Returns the integer id of a node category, the same category always gets the
+ * same id.
+ */
+int intern_category(const std::string &category);
+
+/**
+ * @brief Returns the integer id of a port data type, the same data type always gets the
+ * same id.
+ */
+int intern_data_type(const std::string &data_type);
+
+/**
+ * @brief Drops the colors cached by id, to be called after modifying
+ * Style::Node::color_port_data or Style::Node::color_category once nodes have been
+ * created.
+ */
+void refresh_interned_colors();
+
 } // namespace gngui
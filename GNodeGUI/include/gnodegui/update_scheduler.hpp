@@ -0,0 +1,36 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+
+/**
+ * @file update_scheduler.hpp
+ * @author Otto Link (otto.link.bv@gmail.com)
+ * @brief Coalesced and rate-limited repaint requests of the graph items.
+ * @copyright Copyright (c) 2024 Otto Link. Distributed under the terms of the
+ * GNU General Public License. See the file LICENSE for the full license.
+ */
+#pragma once
+#include <QGraphicsItem>
+#include <QRectF>
+
+namespace gngui
+{
+
+/**
+ * @brief Requests the repaint of a part of an item. The requests are merged per item
+ * (union of the rectangles) and handed over to Qt at most
+ * Style::Viewer::max_repaint_rate times per second, or right away if there is no rate
+ * cap.
+ * @param item Item.
+ * @param rect Area to repaint, in item coordinates.
+ */
+void schedule_item_update(QGraphicsItem *item, const QRectF &rect);
+
+/**
+ * @brief Drops the pending repaint requests of an item, must be called before the
+ * item is destroyed.
+ * @param item Item.
+ */
+void cancel_item_update(QGraphicsItem *item);
+
+} // namespace gngui
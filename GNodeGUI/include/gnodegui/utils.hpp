@@ -21,6 +21,13 @@ namespace gngui
 
 QRectF compute_bounding_rect(const std::vector<QGraphicsItem *> &items);
 
+// squared distance between a point and the segment [a, b]
+float distance_to_segment_squared(const QPointF &p, const QPointF &a, const QPointF &b);
+
 std::vector<std::string> split_string(const std::string &string, char delimiter);
 
+// writes the buffer to 'fname.tmp' and renames it to 'fname', so that
+// 'fname' is never left half written, throws std::runtime_error
+void write_file_atomic(const std::string &fname, const std::string &buffer);
+
 } // namespace gngui
\ No newline at end of file
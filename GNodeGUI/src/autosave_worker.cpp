@@ -0,0 +1,97 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include "gnodegui/autosave_worker.hpp"
+#include "gnodegui/graph_binary.hpp"
+#include "gnodegui/graph_compression.hpp"
+#include "gnodegui/logger.hpp"
+#include "gnodegui/utils.hpp"
+
+namespace gngui
+{
+
+AutosaveWorker::AutosaveWorker()
+{
+  this->thread = std::thread(&AutosaveWorker::run, this);
+}
+
+AutosaveWorker::~AutosaveWorker()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->is_stopping = true;
+  }
+  this->cv.notify_all();
+  this->thread.join();
+}
+
+void AutosaveWorker::run()
+{
+  while (true)
+  {
+    std::unique_ptr<GraphRecord> snapshot;
+    std::string                  fname;
+    bool                         compress = false;
+
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->cv.wait(lock,
+                    [this]() { return this->is_stopping || this->pending_snapshot; });
+
+      if (this->is_stopping)
+        return;
+
+      snapshot = std::move(this->pending_snapshot);
+      fname = std::move(this->pending_fname);
+      compress = this->pending_compress;
+      this->pending_snapshot = nullptr;
+      this->is_busy = true;
+    }
+
+    try
+    {
+      sort_graph_record(*snapshot);
+      std::string buffer = graph_record_to_binary(*snapshot);
+
+      if (compress)
+        buffer = graph_compress(buffer);
+
+      write_file_atomic(fname, buffer);
+      Logger::log()->trace("AutosaveWorker::run, saved {}", fname);
+    }
+    catch (const std::exception &e)
+    {
+      Logger::log()->error("AutosaveWorker::run, {}", e.what());
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->is_busy = false;
+    }
+    this->cv.notify_all();
+  }
+}
+
+void AutosaveWorker::submit(GraphRecord      &&snapshot,
+                            const std::string &fname,
+                            bool               compress)
+{
+  auto p_snapshot = std::make_unique<GraphRecord>(std::move(snapshot));
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->pending_snapshot = std::move(p_snapshot);
+    this->pending_fname = fname;
+    this->pending_compress = compress;
+  }
+  this->cv.notify_all();
+}
+
+void AutosaveWorker::wait_idle()
+{
+  std::unique_lock<std::mutex> lock(this->mutex);
+  this->cv.wait(lock,
+                [this]() { return !this->pending_snapshot && !this->is_busy; });
+}
+
+} // namespace gngui
@@ -0,0 +1,350 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "gnodegui/graph_binary.hpp"
+
+#define GRAPH_BINARY_MAGIC "GNGB"
+#define GRAPH_BINARY_VERSION 1
+#define GRAPH_BINARY_NODE_SIZE 28
+#define GRAPH_BINARY_LINK_SIZE 20
+#define GRAPH_BINARY_GROUP_SIZE 40
+
+namespace gngui
+{
+
+namespace
+{
+
+class BinaryWriter
+{
+public:
+  std::string buffer;
+
+  void put_f64(double value) { this->put_u64(std::bit_cast<uint64_t>(value)); }
+
+  void put_u8(uint8_t value) { this->buffer.push_back((char)value); }
+
+  void put_u32(uint32_t value)
+  {
+    for (int k = 0; k < 4; k++)
+      this->buffer.push_back((char)((value >> (8 * k)) & 0xFF));
+  }
+
+  void put_u64(uint64_t value)
+  {
+    for (int k = 0; k < 8; k++)
+      this->buffer.push_back((char)((value >> (8 * k)) & 0xFF));
+  }
+};
+
+class BinaryReader
+{
+public:
+  BinaryReader(std::string_view buffer) : buffer(buffer) {}
+
+  size_t get_pos() const { return this->pos; }
+
+  // throws if less than 'size' bytes are left
+  void require(size_t size) const
+  {
+    if (this->buffer.size() - this->pos < size)
+      throw std::runtime_error("graph_record_from_binary: truncated buffer");
+  }
+
+  double get_f64() { return std::bit_cast<double>(this->get_u64()); }
+
+  std::string_view get_string_view(size_t size)
+  {
+    this->require(size);
+    std::string_view sv = this->buffer.substr(this->pos, size);
+    this->pos += size;
+    return sv;
+  }
+
+  uint8_t get_u8()
+  {
+    this->require(1);
+    return (uint8_t)this->buffer[this->pos++];
+  }
+
+  uint32_t get_u32()
+  {
+    this->require(4);
+    uint32_t value = 0;
+    for (int k = 0; k < 4; k++)
+      value |= (uint32_t)(uint8_t)this->buffer[this->pos++] << (8 * k);
+    return value;
+  }
+
+  uint64_t get_u64()
+  {
+    this->require(8);
+    uint64_t value = 0;
+    for (int k = 0; k < 8; k++)
+      value |= (uint64_t)(uint8_t)this->buffer[this->pos++] << (8 * k);
+    return value;
+  }
+
+  void skip(size_t size)
+  {
+    this->require(size);
+    this->pos += size;
+  }
+
+  // reads a record count and checks that the records fit in what is
+  // left of the buffer, before anything is allocated
+  uint32_t get_count(size_t record_size)
+  {
+    uint32_t count = this->get_u32();
+    this->require((size_t)count * record_size);
+    return count;
+  }
+
+private:
+  std::string_view buffer;
+  size_t           pos = 0;
+};
+
+} // namespace
+
+GraphBinaryView::GraphBinaryView(std::string_view buffer) : buffer(buffer)
+{
+  if (!is_graph_binary(buffer))
+    throw std::runtime_error("graph_record_from_binary: not a binary graph");
+
+  BinaryReader reader(buffer);
+  reader.skip(4);
+
+  uint32_t version = reader.get_u32();
+  if (version != GRAPH_BINARY_VERSION)
+    throw std::runtime_error("graph_record_from_binary: unsupported version " +
+                             std::to_string(version));
+
+  // string table, views on the input buffer
+  this->strings.resize(reader.get_count(4));
+
+  for (auto &sv : this->strings)
+    sv = reader.get_string_view(reader.get_u32());
+
+  this->id = this->get_string(reader.get_u32());
+  this->current_link_type = (int32_t)reader.get_u32();
+
+  // fixed-width records, only their location is kept
+  this->nnodes = reader.get_count(GRAPH_BINARY_NODE_SIZE);
+  this->nodes_offset = reader.get_pos();
+  reader.skip(this->nnodes * GRAPH_BINARY_NODE_SIZE);
+
+  this->nlinks = reader.get_count(GRAPH_BINARY_LINK_SIZE);
+  this->links_offset = reader.get_pos();
+  reader.skip(this->nlinks * GRAPH_BINARY_LINK_SIZE);
+
+  this->ngroups = reader.get_count(GRAPH_BINARY_GROUP_SIZE);
+  this->groups_offset = reader.get_pos();
+}
+
+GroupRecord GraphBinaryView::get_group(size_t index) const
+{
+  BinaryReader reader(this->buffer.substr(this->groups_offset +
+                                          index * GRAPH_BINARY_GROUP_SIZE,
+                                          GRAPH_BINARY_GROUP_SIZE));
+  GroupRecord  group;
+
+  group.caption = std::string(this->get_string(reader.get_u32()));
+  group.x = reader.get_f64();
+  group.y = reader.get_f64();
+  group.width = reader.get_f64();
+  group.height = reader.get_f64();
+  for (auto &c : group.color)
+    c = reader.get_u8();
+
+  return group;
+}
+
+LinkRecordView GraphBinaryView::get_link(size_t index) const
+{
+  BinaryReader reader(this->buffer.substr(this->links_offset +
+                                          index * GRAPH_BINARY_LINK_SIZE,
+                                          GRAPH_BINARY_LINK_SIZE));
+  LinkRecordView link;
+
+  link.node_out_id = this->get_string(reader.get_u32());
+  link.port_out_id = this->get_string(reader.get_u32());
+  link.node_in_id = this->get_string(reader.get_u32());
+  link.port_in_id = this->get_string(reader.get_u32());
+  link.link_type = (int32_t)reader.get_u32();
+
+  return link;
+}
+
+NodeRecordView GraphBinaryView::get_node(size_t index) const
+{
+  BinaryReader   reader(this->buffer.substr(this->nodes_offset +
+                                              index * GRAPH_BINARY_NODE_SIZE,
+                                            GRAPH_BINARY_NODE_SIZE));
+  NodeRecordView node;
+
+  node.id = this->get_string(reader.get_u32());
+  node.caption = this->get_string(reader.get_u32());
+  node.x = reader.get_f64();
+  node.y = reader.get_f64();
+  node.is_widget_visible = reader.get_u32() & 1;
+
+  return node;
+}
+
+std::string_view GraphBinaryView::get_string(uint32_t index) const
+{
+  if (index >= this->strings.size())
+    throw std::runtime_error("graph_record_from_binary: invalid string index");
+  return this->strings[index];
+}
+
+GraphRecord GraphBinaryView::to_record() const
+{
+  GraphRecord record;
+  record.id = std::string(this->id);
+  record.current_link_type = this->current_link_type;
+
+  record.nodes.reserve(this->nnodes);
+  for (size_t k = 0; k < this->nnodes; k++)
+    record.nodes.push_back(this->get_node(k).to_record());
+
+  record.links.reserve(this->nlinks);
+  for (size_t k = 0; k < this->nlinks; k++)
+    record.links.push_back(this->get_link(k).to_record());
+
+  record.groups.reserve(this->ngroups);
+  for (size_t k = 0; k < this->ngroups; k++)
+    record.groups.push_back(this->get_group(k));
+
+  return record;
+}
+
+LinkRecord LinkRecordView::to_record() const
+{
+  return LinkRecord{std::string(this->node_out_id),
+                    std::string(this->port_out_id),
+                    std::string(this->node_in_id),
+                    std::string(this->port_in_id),
+                    this->link_type};
+}
+
+NodeRecord NodeRecordView::to_record() const
+{
+  return NodeRecord{std::string(this->id),
+                    std::string(this->caption),
+                    this->is_widget_visible,
+                    this->x,
+                    this->y};
+}
+
+bool is_graph_binary(std::string_view buffer)
+{
+  return buffer.starts_with(GRAPH_BINARY_MAGIC);
+}
+
+GraphRecord graph_record_from_binary(std::string_view buffer)
+{
+  return GraphBinaryView(buffer).to_record();
+}
+
+std::string graph_record_to_binary(const GraphRecord &record)
+{
+  // --- string table, each distinct string is stored once
+  std::unordered_map<std::string_view, uint32_t> string_index;
+  std::vector<std::string_view>                  strings;
+
+  auto add_string = [&string_index, &strings](std::string_view sv)
+  {
+    if (string_index.try_emplace(sv, (uint32_t)strings.size()).second)
+      strings.push_back(sv);
+  };
+
+  add_string(record.id);
+
+  for (auto &node : record.nodes)
+  {
+    add_string(node.id);
+    add_string(node.caption);
+  }
+
+  for (auto &link : record.links)
+  {
+    add_string(link.node_out_id);
+    add_string(link.port_out_id);
+    add_string(link.node_in_id);
+    add_string(link.port_in_id);
+  }
+
+  for (auto &group : record.groups)
+    add_string(group.caption);
+
+  // --- write
+  BinaryWriter writer;
+
+  size_t strings_size = 0;
+  for (auto sv : strings)
+    strings_size += 4 + sv.size();
+
+  writer.buffer.reserve(32 + strings_size +
+                        record.nodes.size() * GRAPH_BINARY_NODE_SIZE +
+                        record.links.size() * GRAPH_BINARY_LINK_SIZE +
+                        record.groups.size() * GRAPH_BINARY_GROUP_SIZE);
+
+  writer.buffer.append(GRAPH_BINARY_MAGIC);
+  writer.put_u32(GRAPH_BINARY_VERSION);
+
+  writer.put_u32((uint32_t)strings.size());
+  for (auto sv : strings)
+  {
+    writer.put_u32((uint32_t)sv.size());
+    writer.buffer.append(sv);
+  }
+
+  auto put_string = [&writer, &string_index](std::string_view sv)
+  { writer.put_u32(string_index.at(sv)); };
+
+  put_string(record.id);
+  writer.put_u32((uint32_t)record.current_link_type);
+
+  writer.put_u32((uint32_t)record.nodes.size());
+  for (auto &node : record.nodes)
+  {
+    put_string(node.id);
+    put_string(node.caption);
+    writer.put_f64(node.x);
+    writer.put_f64(node.y);
+    writer.put_u32(node.is_widget_visible ? 1 : 0);
+  }
+
+  writer.put_u32((uint32_t)record.links.size());
+  for (auto &link : record.links)
+  {
+    put_string(link.node_out_id);
+    put_string(link.port_out_id);
+    put_string(link.node_in_id);
+    put_string(link.port_in_id);
+    writer.put_u32((uint32_t)link.link_type);
+  }
+
+  writer.put_u32((uint32_t)record.groups.size());
+  for (auto &group : record.groups)
+  {
+    put_string(group.caption);
+    writer.put_f64(group.x);
+    writer.put_f64(group.y);
+    writer.put_f64(group.width);
+    writer.put_f64(group.height);
+    for (int c : group.color)
+      writer.put_u8((uint8_t)c);
+  }
+
+  return std::move(writer.buffer);
+}
+
+} // namespace gngui
@@ -0,0 +1,242 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifdef GNODEGUI_USE_ZLIB
+#include <zlib.h>
+#else
+#include <QByteArray>
+#endif
+
+#include "gnodegui/graph_compression.hpp"
+
+#define GRAPH_COMPRESSION_MAGIC "GNGZ"
+#define GRAPH_COMPRESSION_VERSION 1
+// bounds applied to the block table before allocating anything, deflate
+// cannot expand data by more than ~1032:1
+#define GRAPH_COMPRESSION_MAX_BLOCK_SIZE (64u << 20)
+#define GRAPH_COMPRESSION_MAX_RATIO 1032
+
+namespace gngui
+{
+
+// zlib stream of a block, false on failure
+static bool compress_block(std::string_view input, int level, std::string &output)
+{
+#ifdef GNODEGUI_USE_ZLIB
+  uLongf size = compressBound((uLong)input.size());
+  output.resize(size);
+
+  int ret = compress2((Bytef *)output.data(),
+                     &size,
+                     (const Bytef *)input.data(),
+                     (uLong)input.size(),
+                     level);
+  output.resize(size);
+  return ret == Z_OK;
+#else
+  // qCompress prepends the uncompressed size (4 bytes, big-endian) to
+  // the zlib stream, not stored since the block table already has it
+  QByteArray ba = qCompress((const uchar *)input.data(), (qsizetype)input.size(), level);
+
+  if (ba.size() < 4)
+    return false;
+
+  output.assign(ba.constData() + 4, (size_t)ba.size() - 4);
+  return true;
+#endif
+}
+
+// inflates a block straight into 'output' (of size 'raw_size'), false on
+// failure or if the stream does not have exactly 'raw_size' bytes
+static bool decompress_block(std::string_view input, char *output, size_t raw_size)
+{
+#ifdef GNODEGUI_USE_ZLIB
+  uLongf size = (uLongf)raw_size;
+
+  int ret = uncompress((Bytef *)output,
+                       &size,
+                       (const Bytef *)input.data(),
+                       (uLong)input.size());
+  return ret == Z_OK && size == raw_size;
+#else
+  QByteArray ba;
+  ba.reserve((qsizetype)input.size() + 4);
+
+  for (int k = 3; k >= 0; k--)
+    ba.append((char)((raw_size >> (8 * k)) & 0xFF));
+  ba.append(input.data(), (qsizetype)input.size());
+
+  QByteArray raw = qUncompress(ba);
+
+  if ((size_t)raw.size() != raw_size)
+    return false;
+
+  std::memcpy(output, raw.constData(), raw_size);
+  return true;
+#endif
+}
+
+static uint32_t get_u32(std::string_view buffer, size_t pos)
+{
+  uint32_t value = 0;
+  for (int k = 0; k < 4; k++)
+    value |= (uint32_t)(uint8_t)buffer[pos + k] << (8 * k);
+  return value;
+}
+
+static void put_u32(std::string &buffer, uint32_t value)
+{
+  for (int k = 0; k < 4; k++)
+    buffer.push_back((char)((value >> (8 * k)) & 0xFF));
+}
+
+// runs 'task(k)' for k in [0, count) on all the cores, the first
+// exception thrown by a task is rethrown
+static void run_parallel(size_t count, const std::function<void(size_t)> &task)
+{
+  size_t nthreads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                     count);
+
+  if (nthreads <= 1)
+  {
+    for (size_t k = 0; k < count; k++)
+      task(k);
+    return;
+  }
+
+  std::vector<std::thread>        threads;
+  std::vector<std::exception_ptr> errors(nthreads);
+
+  for (size_t t = 0; t < nthreads; t++)
+    threads.emplace_back(
+        [&, t]()
+        {
+          try
+          {
+            for (size_t k = t; k < count; k += nthreads)
+              task(k);
+          }
+          catch (...)
+          {
+            errors[t] = std::current_exception();
+          }
+        });
+
+  for (auto &thread : threads)
+    thread.join();
+
+  for (auto &error : errors)
+    if (error)
+      std::rethrow_exception(error);
+}
+
+std::string graph_compress(std::string_view buffer, int level, size_t block_size)
+{
+  block_size = std::clamp<size_t>(block_size, 1, GRAPH_COMPRESSION_MAX_BLOCK_SIZE);
+  size_t nblocks = (buffer.size() + block_size - 1) / block_size;
+
+  std::vector<std::string> blocks(nblocks);
+
+  run_parallel(nblocks,
+               [&](size_t k)
+               {
+                 std::string_view input = buffer.substr(k * block_size, block_size);
+                 if (!compress_block(input, level, blocks[k]))
+                   throw std::runtime_error("graph_compress: compression failed");
+               });
+
+  // header, block table and data
+  std::string output;
+  size_t      data_size = 0;
+
+  for (auto &block : blocks)
+    data_size += block.size();
+
+  output.reserve(12 + 8 * nblocks + data_size);
+  output.append(GRAPH_COMPRESSION_MAGIC);
+  put_u32(output, GRAPH_COMPRESSION_VERSION);
+  put_u32(output, (uint32_t)nblocks);
+
+  for (size_t k = 0; k < nblocks; k++)
+  {
+    put_u32(output, (uint32_t)std::min(block_size, buffer.size() - k * block_size));
+    put_u32(output, (uint32_t)blocks[k].size());
+  }
+
+  for (auto &block : blocks)
+    output.append(block);
+
+  return output;
+}
+
+std::string graph_decompress(std::string_view buffer)
+{
+  if (!is_graph_compressed(buffer) || buffer.size() < 12)
+    throw std::runtime_error("graph_decompress: not a compressed graph");
+
+  uint32_t version = get_u32(buffer, 4);
+  if (version != GRAPH_COMPRESSION_VERSION)
+    throw std::runtime_error("graph_decompress: unsupported version " +
+                             std::to_string(version));
+
+  size_t nblocks = get_u32(buffer, 8);
+
+  if ((buffer.size() - 12) / 8 < nblocks)
+    throw std::runtime_error("graph_decompress: truncated buffer");
+
+  // locate the blocks in the input and in the output
+  std::vector<size_t> input_offsets(nblocks);
+  std::vector<size_t> output_offsets(nblocks);
+  std::vector<size_t> raw_sizes(nblocks);
+  std::vector<size_t> sizes(nblocks);
+
+  size_t input_offset = 12 + 8 * nblocks;
+  size_t output_size = 0;
+
+  for (size_t k = 0; k < nblocks; k++)
+  {
+    raw_sizes[k] = get_u32(buffer, 12 + 8 * k);
+    sizes[k] = get_u32(buffer, 16 + 8 * k);
+
+    if (raw_sizes[k] > GRAPH_COMPRESSION_MAX_BLOCK_SIZE ||
+        raw_sizes[k] > (size_t)sizes[k] * GRAPH_COMPRESSION_MAX_RATIO)
+      throw std::runtime_error("graph_decompress: invalid block size");
+
+    input_offsets[k] = input_offset;
+    output_offsets[k] = output_size;
+    input_offset += sizes[k];
+    output_size += raw_sizes[k];
+  }
+
+  if (input_offset > buffer.size())
+    throw std::runtime_error("graph_decompress: truncated buffer");
+
+  std::string output(output_size, '\0');
+
+  run_parallel(nblocks,
+               [&](size_t k)
+               {
+                 if (!decompress_block(buffer.substr(input_offsets[k], sizes[k]),
+                                       output.data() + output_offsets[k],
+                                       raw_sizes[k]))
+                   throw std::runtime_error("graph_decompress: corrupted block");
+               });
+
+  return output;
+}
+
+bool is_graph_compressed(std::string_view buffer)
+{
+  return buffer.starts_with(GRAPH_COMPRESSION_MAGIC);
+}
+
+} // namespace gngui
@@ -0,0 +1,175 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <stdexcept>
+
+#include "gnodegui/graph_json_sax.hpp"
+
+namespace gngui
+{
+
+namespace
+{
+
+// SAX handler rebuilding a small JSON tree for one record at a time
+// (an element of the top-level "nodes", "links" or "groups" arrays),
+// top-level scalars are forwarded directly
+class GraphJsonSaxHandler : public nlohmann::json_sax<nlohmann::json>
+{
+public:
+  GraphJsonSaxHandler(const GraphJsonSaxCallbacks &callbacks) : callbacks(callbacks) {}
+
+  bool null() override { return this->add_value(nullptr); }
+
+  bool boolean(bool val) override { return this->add_value(val); }
+
+  bool number_integer(number_integer_t val) override { return this->add_value(val); }
+
+  bool number_unsigned(number_unsigned_t val) override { return this->add_value(val); }
+
+  bool number_float(number_float_t val, const string_t &) override
+  {
+    return this->add_value(val);
+  }
+
+  bool string(string_t &val) override { return this->add_value(std::move(val)); }
+
+  bool binary(binary_t &val) override
+  {
+    return this->add_value(nlohmann::json::binary(std::move(val)));
+  }
+
+  bool start_object(std::size_t) override
+  {
+    return this->start_container(nlohmann::json::object());
+  }
+
+  bool end_object() override { return this->end_container(); }
+
+  bool start_array(std::size_t) override
+  {
+    return this->start_container(nlohmann::json::array());
+  }
+
+  bool end_array() override { return this->end_container(); }
+
+  bool key(string_t &val) override
+  {
+    if (this->depth == 1)
+      this->top_key = val;
+    else
+      this->current_key = val;
+    return true;
+  }
+
+  bool parse_error(std::size_t                        position,
+                   const std::string                 &last_token,
+                   const nlohmann::detail::exception &ex) override
+  {
+    throw std::runtime_error("read_graph_json_sax: parse error at byte " +
+                             std::to_string(position) + " near '" + last_token +
+                             "': " + ex.what());
+  }
+
+private:
+  const GraphJsonSaxCallbacks &callbacks;
+
+  int         depth = 0; // nesting level, 1 inside the top-level object
+  std::string top_key;   // current key of the top-level object
+  std::string current_key;
+
+  nlohmann::json                record;
+  std::vector<nlohmann::json *> stack; // open containers of the current record
+
+  bool add_value(nlohmann::json &&value)
+  {
+    if (this->stack.empty())
+    {
+      // top-level scalar
+      if (this->depth == 1)
+      {
+        if (this->top_key == "id" && value.is_string() && this->callbacks.on_id)
+          this->callbacks.on_id(value.get<std::string>());
+        else if (this->top_key == "current_link_type" && value.is_number() &&
+                 this->callbacks.on_current_link_type)
+          this->callbacks.on_current_link_type(value.get<int>());
+      }
+      return true;
+    }
+
+    this->insert(std::move(value));
+    return true;
+  }
+
+  void dispatch_record()
+  {
+    if (this->top_key == "nodes")
+    {
+      if (this->callbacks.on_node)
+        this->callbacks.on_node(node_record_from_json(this->record));
+    }
+    else if (this->top_key == "links")
+    {
+      if (this->callbacks.on_link)
+        this->callbacks.on_link(link_record_from_json(this->record));
+    }
+    else if (this->top_key == "groups")
+    {
+      if (this->callbacks.on_group)
+        this->callbacks.on_group(group_record_from_json(this->record));
+    }
+
+    this->record = nullptr;
+  }
+
+  bool end_container()
+  {
+    if (!this->stack.empty())
+    {
+      this->stack.pop_back();
+      if (this->stack.empty())
+        this->dispatch_record();
+    }
+
+    this->depth--;
+    return true;
+  }
+
+  nlohmann::json *insert(nlohmann::json &&value)
+  {
+    nlohmann::json *p_parent = this->stack.back();
+
+    if (p_parent->is_object())
+      return &((*p_parent)[this->current_key] = std::move(value));
+
+    p_parent->push_back(std::move(value));
+    return &p_parent->back();
+  }
+
+  bool start_container(nlohmann::json &&container)
+  {
+    if (!this->stack.empty())
+      this->stack.push_back(this->insert(std::move(container)));
+    else if (this->depth == 2 && container.is_object() &&
+             (this->top_key == "nodes" || this->top_key == "links" ||
+              this->top_key == "groups"))
+    {
+      // new record in one of the top-level arrays
+      this->record = std::move(container);
+      this->stack.push_back(&this->record);
+    }
+
+    this->depth++;
+    return true;
+  }
+};
+
+} // namespace
+
+void read_graph_json_sax(std::istream &is, const GraphJsonSaxCallbacks &callbacks)
+{
+  GraphJsonSaxHandler handler(callbacks);
+  nlohmann::json::sax_parse(is, &handler);
+}
+
+} // namespace gngui
@@ -0,0 +1,247 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "gnodegui/graph_patch.hpp"
+
+namespace gngui
+{
+
+// links have no id, they are keyed by their ends
+static std::string link_key(const LinkRecord &link)
+{
+  return link.node_out_id + '\0' + link.port_out_id + '\0' + link.node_in_id + '\0' +
+         link.port_in_id;
+}
+
+void apply_graph_journal(GraphRecord &record, std::istream &is)
+{
+  std::string line;
+
+  while (std::getline(is, line))
+    if (!line.empty())
+      apply_graph_patch(record, graph_patch_from_json(nlohmann::json::parse(line)));
+}
+
+void apply_graph_patch(GraphRecord &record, const GraphPatch &patch)
+{
+  if (patch.clear)
+  {
+    record.nodes.clear();
+    record.links.clear();
+    record.groups.clear();
+  }
+
+  // --- removals
+
+  if (!patch.removed_links.empty())
+  {
+    std::unordered_set<std::string> keys;
+    keys.reserve(patch.removed_links.size());
+    for (auto &link : patch.removed_links)
+      keys.insert(link_key(link));
+
+    std::erase_if(record.links,
+                  [&keys](const LinkRecord &link)
+                  { return keys.contains(link_key(link)); });
+  }
+
+  if (!patch.removed_nodes.empty())
+  {
+    std::unordered_set<std::string> ids(patch.removed_nodes.begin(),
+                                        patch.removed_nodes.end());
+
+    std::erase_if(record.nodes,
+                  [&ids](const NodeRecord &node) { return ids.contains(node.id); });
+  }
+
+  // --- additions and modifications
+
+  record.nodes.insert(record.nodes.end(),
+                      patch.added_nodes.begin(),
+                      patch.added_nodes.end());
+
+  if (!patch.moved_nodes.empty())
+  {
+    std::unordered_map<std::string, size_t> index_by_id;
+    for (size_t k = 0; k < record.nodes.size(); k++)
+      index_by_id[record.nodes[k].id] = k;
+
+    for (auto &node : patch.moved_nodes)
+      if (auto it = index_by_id.find(node.id); it != index_by_id.end())
+        record.nodes[it->second] = node;
+  }
+
+  record.links.insert(record.links.end(),
+                      patch.added_links.begin(),
+                      patch.added_links.end());
+
+  if (patch.groups)
+    record.groups = *patch.groups;
+
+  if (patch.current_link_type)
+  {
+    record.current_link_type = *patch.current_link_type;
+    for (auto &link : record.links)
+      link.link_type = *patch.current_link_type;
+  }
+}
+
+GraphPatch graph_diff(const GraphRecord &from, const GraphRecord &to)
+{
+  GraphPatch patch;
+
+  // --- nodes
+
+  std::unordered_map<std::string_view, const NodeRecord *> from_nodes;
+  from_nodes.reserve(from.nodes.size());
+
+  for (auto &node : from.nodes)
+    from_nodes.emplace(node.id, &node);
+
+  for (auto &node : to.nodes)
+  {
+    auto it = from_nodes.find(node.id);
+
+    if (it == from_nodes.end())
+      patch.added_nodes.push_back(node);
+    else
+    {
+      if (!(*it->second == node))
+        patch.moved_nodes.push_back(node);
+      from_nodes.erase(it);
+    }
+  }
+
+  // what is left has been removed, listed in the initial order
+  for (auto &node : from.nodes)
+    if (from_nodes.contains(node.id))
+      patch.removed_nodes.push_back(node.id);
+
+  // --- links, keyed by their ends
+
+  std::unordered_set<std::string> from_links;
+  std::unordered_set<std::string> to_links;
+  from_links.reserve(from.links.size());
+  to_links.reserve(to.links.size());
+
+  for (auto &link : from.links)
+    from_links.insert(link_key(link));
+
+  for (auto &link : to.links)
+  {
+    std::string key = link_key(link);
+
+    if (!from_links.contains(key))
+      patch.added_links.push_back(link);
+    to_links.insert(std::move(key));
+  }
+
+  for (auto &link : from.links)
+    if (!to_links.contains(link_key(link)))
+      patch.removed_links.push_back(link);
+
+  // --- groups and link type
+
+  if (from.groups != to.groups)
+    patch.groups = to.groups;
+
+  if (from.current_link_type != to.current_link_type)
+    patch.current_link_type = to.current_link_type;
+
+  return patch;
+}
+
+GraphPatch graph_patch_from_json(const nlohmann::json &json)
+{
+  GraphPatch patch;
+
+  patch.clear = json.value("clear", false);
+
+  if (json.contains("removed_links"))
+    for (auto &json_link : json["removed_links"])
+      patch.removed_links.push_back(link_record_from_json(json_link));
+
+  if (json.contains("removed_nodes"))
+    patch.removed_nodes = json["removed_nodes"].get<std::vector<std::string>>();
+
+  if (json.contains("added_nodes"))
+    for (auto &json_node : json["added_nodes"])
+      patch.added_nodes.push_back(node_record_from_json(json_node));
+
+  if (json.contains("moved_nodes"))
+    for (auto &json_node : json["moved_nodes"])
+      patch.moved_nodes.push_back(node_record_from_json(json_node));
+
+  if (json.contains("added_links"))
+    for (auto &json_link : json["added_links"])
+      patch.added_links.push_back(link_record_from_json(json_link));
+
+  if (json.contains("groups"))
+  {
+    patch.groups.emplace();
+    for (auto &json_group : json["groups"])
+      patch.groups->push_back(group_record_from_json(json_group));
+  }
+
+  if (json.contains("current_link_type"))
+    patch.current_link_type = json["current_link_type"].get<int>();
+
+  return patch;
+}
+
+nlohmann::json graph_patch_to_json(const GraphPatch &patch)
+{
+  // only the non-empty parts are written
+  nlohmann::json json = nlohmann::json::object();
+
+  if (patch.clear)
+    json["clear"] = true;
+
+  for (auto &link : patch.removed_links)
+    json["removed_links"].push_back(link_record_to_json(link));
+
+  if (!patch.removed_nodes.empty())
+    json["removed_nodes"] = patch.removed_nodes;
+
+  for (auto &node : patch.added_nodes)
+    json["added_nodes"].push_back(node_record_to_json(node));
+
+  for (auto &node : patch.moved_nodes)
+    json["moved_nodes"].push_back(node_record_to_json(node));
+
+  for (auto &link : patch.added_links)
+    json["added_links"].push_back(link_record_to_json(link));
+
+  if (patch.groups)
+  {
+    json["groups"] = nlohmann::json::array();
+    for (auto &group : *patch.groups)
+      json["groups"].push_back(group_record_to_json(group));
+  }
+
+  if (patch.current_link_type)
+    json["current_link_type"] = *patch.current_link_type;
+
+  return json;
+}
+
+bool GraphPatch::is_empty() const
+{
+  return !this->clear && this->removed_links.empty() && this->removed_nodes.empty() &&
+         this->added_nodes.empty() && this->moved_nodes.empty() &&
+         this->added_links.empty() && !this->groups && !this->current_link_type;
+}
+
+bool is_same_link(const LinkRecord &a, const LinkRecord &b)
+{
+  return a.node_out_id == b.node_out_id && a.port_out_id == b.port_out_id &&
+         a.node_in_id == b.node_in_id && a.port_in_id == b.port_in_id;
+}
+
+} // namespace gngui
@@ -0,0 +1,205 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <algorithm>
+#include <tuple>
+
+#include "gnodegui/graph_record.hpp"
+
+namespace gngui
+{
+
+GroupRecord group_record_from_json(const nlohmann::json &json)
+{
+  // 'at' throws a json exception on missing keys and short arrays, the
+  // input may come from a corrupted file
+  GroupRecord record;
+
+  const nlohmann::json &pos = json.at("position");
+  record.x = pos.at(0);
+  record.y = pos.at(1);
+  record.width = json.at("width");
+  record.height = json.at("height");
+  record.caption = json.at("caption");
+
+  const nlohmann::json &color = json.at("color");
+  for (size_t k = 0; k < 4; k++)
+    record.color[k] = (int)color.at(k).get<float>();
+
+  return record;
+}
+
+nlohmann::json group_record_to_json(const GroupRecord &record)
+{
+  nlohmann::json json;
+
+  json["caption"] = record.caption;
+  json["position"] = {record.x, record.y};
+  json["width"] = record.width;
+  json["height"] = record.height;
+  json["color"] = record.color;
+
+  return json;
+}
+
+GraphRecord graph_record_from_json(const nlohmann::json &json)
+{
+  GraphRecord record;
+
+  record.id = json.value("id", "");
+  record.current_link_type = json.value("current_link_type", 0);
+
+  if (json.contains("nodes") && !json["nodes"].is_null())
+  {
+    record.nodes.reserve(json["nodes"].size());
+    for (auto &json_node : json["nodes"])
+      record.nodes.push_back(node_record_from_json(json_node));
+  }
+
+  if (json.contains("links") && !json["links"].is_null())
+  {
+    record.links.reserve(json["links"].size());
+    for (auto &json_link : json["links"])
+      record.links.push_back(link_record_from_json(json_link));
+  }
+
+  if (json.contains("groups") && !json["groups"].is_null())
+  {
+    record.groups.reserve(json["groups"].size());
+    for (auto &json_group : json["groups"])
+      record.groups.push_back(group_record_from_json(json_group));
+  }
+
+  return record;
+}
+
+std::string graph_record_dump(const GraphRecord &record)
+{
+  nlohmann::json json_group_list = nlohmann::json::array();
+
+  for (auto &group : record.groups)
+    json_group_list.push_back(group_record_to_json(group));
+
+  std::string text = "{\"current_link_type\":" + std::to_string(record.current_link_type);
+  text += ",\"groups\":" + json_group_list.dump();
+  text += ",\"id\":" + nlohmann::json(record.id).dump();
+
+  text += ",\"nodes\":[";
+  for (size_t k = 0; k < record.nodes.size(); k++)
+  {
+    if (k > 0)
+      text += ',';
+    text += node_record_to_json(record.nodes[k]).dump();
+  }
+
+  text += "],\"links\":[";
+  for (size_t k = 0; k < record.links.size(); k++)
+  {
+    if (k > 0)
+      text += ',';
+    text += link_record_to_json(record.links[k]).dump();
+  }
+
+  text += "]}";
+
+  return text;
+}
+
+nlohmann::json graph_record_to_json(const GraphRecord &record)
+{
+  nlohmann::json json;
+
+  json["id"] = record.id;
+  json["current_link_type"] = record.current_link_type;
+
+  std::vector<nlohmann::json> json_node_list = {};
+  std::vector<nlohmann::json> json_link_list = {};
+  std::vector<nlohmann::json> json_group_list = {};
+
+  json_node_list.reserve(record.nodes.size());
+  json_link_list.reserve(record.links.size());
+  json_group_list.reserve(record.groups.size());
+
+  for (auto &node : record.nodes)
+    json_node_list.push_back(node_record_to_json(node));
+
+  for (auto &link : record.links)
+    json_link_list.push_back(link_record_to_json(link));
+
+  for (auto &group : record.groups)
+    json_group_list.push_back(group_record_to_json(group));
+
+  json["nodes"] = json_node_list;
+  json["links"] = json_link_list;
+  json["groups"] = json_group_list;
+
+  return json;
+}
+
+bool is_link_record_before(const LinkRecord &a, const LinkRecord &b)
+{
+  return std::tie(a.node_out_id, a.port_out_id, a.node_in_id, a.port_in_id) <
+         std::tie(b.node_out_id, b.port_out_id, b.node_in_id, b.port_in_id);
+}
+
+LinkRecord link_record_from_json(const nlohmann::json &json)
+{
+  LinkRecord record;
+
+  record.node_out_id = json.at("node_out_id");
+  record.node_in_id = json.at("node_in_id");
+  record.port_out_id = json.at("port_out_id");
+  record.port_in_id = json.at("port_in_id");
+  record.link_type = json.value("link_type", 0);
+
+  return record;
+}
+
+nlohmann::json link_record_to_json(const LinkRecord &record)
+{
+  nlohmann::json json;
+
+  json["node_out_id"] = record.node_out_id;
+  json["node_in_id"] = record.node_in_id;
+  json["port_out_id"] = record.port_out_id;
+  json["port_in_id"] = record.port_in_id;
+  json["link_type"] = record.link_type;
+
+  return json;
+}
+
+NodeRecord node_record_from_json(const nlohmann::json &json)
+{
+  NodeRecord record;
+
+  record.id = json.at("id");
+  record.caption = json.value("caption", "");
+  record.is_widget_visible = json.value("is_widget_visible", true);
+  record.x = json.at("scene_position.x");
+  record.y = json.at("scene_position.y");
+
+  return record;
+}
+
+nlohmann::json node_record_to_json(const NodeRecord &record)
+{
+  nlohmann::json json;
+
+  json["id"] = record.id;
+  json["caption"] = record.caption;
+  json["is_widget_visible"] = record.is_widget_visible;
+  json["scene_position.x"] = record.x;
+  json["scene_position.y"] = record.y;
+
+  return json;
+}
+
+void sort_graph_record(GraphRecord &record)
+{
+  std::sort(record.nodes.begin(),
+            record.nodes.end(),
+            [](const NodeRecord &a, const NodeRecord &b) { return a.id < b.id; });
+  std::sort(record.links.begin(), record.links.end(), is_link_record_before);
+}
+
+} // namespace gngui
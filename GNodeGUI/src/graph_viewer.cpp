@@ -1,14 +1,29 @@
 /* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <map>
+#include <streambuf>
 
+#include <QCryptographicHash>
+#include <QFile>
 #include <QKeyEvent>
 #include <QLineEdit>
 #include <QMenu>
+#include <QPaintEvent>
+#include <QPainter>
+#include <QPixmapCache>
+#include <QScrollBar>
 #include <QWidgetAction>
 
+#include "gnodegui/graph_binary.hpp"
+#include "gnodegui/graph_compression.hpp"
+#include "gnodegui/graph_json_sax.hpp"
+#include "gnodegui/graph_patch.hpp"
 #include "gnodegui/graph_viewer.hpp"
 #include "gnodegui/graphics_group.hpp"
 #include "gnodegui/logger.hpp"
@@ -29,10 +44,72 @@
 #include "gnodegui/icons/viewport_icon.hpp"
 
 #define MAX_SIZE 40000
+// room kept around the content when the scene rect grows
+#define SCENE_RECT_MARGIN 10000
+// cell size of the grid used to find the visible node placeholders
+#define PLACEHOLDER_GRID_CELL 2048.f
 
 namespace gngui
 {
 
+// read-only stream on a memory block (no copy)
+class MemoryStreamBuffer : public std::streambuf
+{
+public:
+  MemoryStreamBuffer(std::string_view buffer)
+  {
+    char *begin = const_cast<char *>(buffer.data());
+    this->setg(begin, begin, begin + buffer.size());
+  }
+};
+
+// O(1) removal from a registry vector, the last item takes the slot of
+// the removed one (item order is not preserved)
+template <typename T>
+static void erase_from_registry(std::vector<T *>                &items,
+                                std::unordered_map<T *, size_t> &slots,
+                                T                               *p_item)
+{
+  auto it = slots.find(p_item);
+  if (it == slots.end())
+    return;
+
+  size_t slot = it->second;
+  slots.erase(it);
+
+  if (slot != items.size() - 1)
+  {
+    items[slot] = items.back();
+    slots[items[slot]] = slot;
+  }
+  items.pop_back();
+}
+
+static std::vector<int64_t> get_grid_keys(const QRectF &rect)
+{
+  int i0 = (int)std::floor(rect.left() / PLACEHOLDER_GRID_CELL);
+  int i1 = (int)std::floor(rect.right() / PLACEHOLDER_GRID_CELL);
+  int j0 = (int)std::floor(rect.top() / PLACEHOLDER_GRID_CELL);
+  int j1 = (int)std::floor(rect.bottom() / PLACEHOLDER_GRID_CELL);
+
+  std::vector<int64_t> keys = {};
+  keys.reserve((size_t)(i1 - i0 + 1) * (size_t)(j1 - j0 + 1));
+
+  for (int i = i0; i <= i1; i++)
+    for (int j = j0; j <= j1; j++)
+      keys.push_back(((int64_t)i << 32) | (uint32_t)j);
+
+  return keys;
+}
+
+// identifies the base file a journal has been written for (its first
+// line), see save_full
+static std::string get_journal_stamp(std::string_view base)
+{
+  QByteArrayView data(base.data(), (qsizetype)base.size());
+  return QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex().toStdString();
+}
+
 GraphViewer::GraphViewer(std::string id) : QGraphicsView(), id(id)
 {
   Logger::log()->trace("GraphViewer::GraphViewer");
@@ -41,30 +118,131 @@ GraphViewer::GraphViewer(std::string id) : QGraphicsView(), id(id)
   this->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
   this->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
   this->setDragMode(QGraphicsView::NoDrag);
+  this->setViewportUpdateMode(GN_STYLE->viewer.viewport_update_mode);
 
   this->setScene(new QGraphicsScene());
   this->scene()->setSceneRect(-MAX_SIZE, -MAX_SIZE, (MAX_SIZE * 2), (MAX_SIZE * 2));
 
+  // batched links, follows the scene rect
+  this->link_batch = new GraphicsLinkBatch();
+  this->link_batch->set_bounding_rect(this->scene()->sceneRect());
+  this->scene()->addItem(this->link_batch);
+  this->connect(this->scene(),
+                &QGraphicsScene::sceneRectChanged,
+                [this](const QRectF &rect)
+                { this->link_batch->set_bounding_rect(rect); });
+
   this->setBackgroundBrush(QBrush(GN_STYLE->viewer.color_bg));
 
+  // room for the nodes render cache
+  QPixmapCache::setCacheLimit(
+      std::max(QPixmapCache::cacheLimit(), GN_STYLE->viewer.pixmap_cache_limit));
+
   if (GN_STYLE->viewer.add_toolbar)
     this->add_toolbar(GN_STYLE->viewer.toolbar_window_pos);
+
+  // lazy nodes are materialized once the view has settled (coalesces
+  // the scroll/zoom steps)
+  this->materialization_timer = new QTimer(this);
+  this->materialization_timer->setSingleShot(true);
+  this->materialization_timer->setInterval(0);
+  this->connect(this->materialization_timer,
+                &QTimer::timeout,
+                [this]() { this->materialize_visible_nodes(); });
+
+  this->connect(this->horizontalScrollBar(),
+                &QScrollBar::valueChanged,
+                [this]() { this->schedule_materialization(); });
+  this->connect(this->verticalScrollBar(),
+                &QScrollBar::valueChanged,
+                [this]() { this->schedule_materialization(); });
+}
+
+void GraphViewer::add_group_record(const GroupRecord &record)
+{
+  GraphicsGroup *p_group = new GraphicsGroup();
+  this->add_item(p_group);
+  p_group->record_from(record);
 }
 
 void GraphViewer::add_item(QGraphicsItem *item, QPointF scene_pos)
 {
   item->setPos(scene_pos);
   this->scene()->addItem(item);
+  this->register_item(item);
+}
 
-  // if this item is GraphicsNode, install the required event filter
-  if (GraphicsNode *node = dynamic_cast<GraphicsNode *>(item))
-    for (QGraphicsItem *other_item : this->scene()->items())
-      if (GraphicsNode *other_node = dynamic_cast<GraphicsNode *>(other_item))
-        if (node != other_node)
-        {
-          node->installSceneEventFilter(other_node);
-          other_node->installSceneEventFilter(node);
-        }
+GraphicsLink *GraphViewer::add_link(GraphicsNode *from_node,
+                                    int           port_from_index,
+                                    GraphicsNode *to_node,
+                                    int           port_to_index)
+{
+  PortType from_type = from_node->get_port_type(port_from_index);
+  PortType to_type = to_node->get_port_type(port_to_index);
+
+  if (from_node == to_node || from_type == to_type ||
+      !from_node->is_port_available(port_from_index) ||
+      !to_node->is_port_available(port_to_index))
+    return nullptr;
+
+  GraphicsLink *p_link = new GraphicsLink(QColor(0, 0, 0, 0), this->current_link_type);
+  p_link->set_pen_style(Qt::SolidLine);
+  p_link->set_endnodes(from_node, port_from_index, to_node, port_to_index);
+
+  this->scene()->addItem(p_link);
+  this->register_link(p_link);
+
+  GraphicsNode *node_out = p_link->get_node_out();
+  GraphicsNode *node_in = p_link->get_node_in();
+
+  Q_EMIT this->connection_finished(node_out->get_id(),
+                                   node_out->get_port_id(p_link->get_port_out_index()),
+                                   node_in->get_id(),
+                                   node_in->get_port_id(p_link->get_port_in_index()));
+
+  return p_link;
+}
+
+void GraphViewer::add_link_record(const LinkRecord &record, const std::string &prefix_id)
+{
+  std::string node_out_id = prefix_id + record.node_out_id;
+  std::string node_in_id = prefix_id + record.node_in_id;
+
+  GraphicsNode *from_node = this->find_node(node_out_id);
+  GraphicsNode *to_node = this->find_node(node_in_id);
+
+  if (!from_node || !to_node)
+  {
+    Logger::log()->error(
+        "GraphViewer::add_link_record, nodes instance cannot be found, IDs: {} and/or {}",
+        node_out_id,
+        node_in_id);
+    return;
+  }
+
+  int port_from_index = from_node->get_port_index(record.port_out_id);
+  int port_to_index = to_node->get_port_index(record.port_in_id);
+
+  if (port_from_index < 0 || port_to_index < 0)
+  {
+    Logger::log()->error(
+        "GraphViewer::add_link_record, ports cannot be found, IDs: {}/{} and/or {}/{}",
+        node_out_id,
+        record.port_out_id,
+        node_in_id,
+        record.port_in_id);
+    return;
+  }
+
+  // the graphic links are generated but the data connection itself is
+  // outsourced to the outter headless nodes manager (through the
+  // connection_finished signal)
+  if (!this->add_link(from_node, port_from_index, to_node, port_to_index))
+    Logger::log()->error("GraphViewer::add_link_record, link {}/{} -> {}/{} rejected",
+                         node_out_id,
+                         record.port_out_id,
+                         node_in_id,
+                         record.port_in_id);
 }
 
 std::string GraphViewer::add_node(NodeProxy         *p_node_proxy,
@@ -72,6 +250,20 @@ std::string GraphViewer::add_node(NodeProxy         *p_node_proxy,
                                   const std::string &node_id)
 {
   GraphicsNode *p_node = new GraphicsNode(p_node_proxy);
+
+  // if nothing provided, generate a unique id based on the object
+  // address (set before the node is registered)
+  std::string nid = node_id;
+
+  if (node_id == "")
+  {
+    std::ostringstream oss;
+    oss << std::to_string((unsigned long long)(void **)p_node);
+    nid = oss.str();
+  }
+
+  p_node_proxy->set_id(nid);
+
   this->add_item(p_node, scene_pos);
 
   this->connect(p_node,
@@ -112,29 +304,91 @@ std::string GraphViewer::add_node(NodeProxy         *p_node_proxy,
                 &GraphicsNode::deselected,
                 [this](const std::string &id) { Q_EMIT this->node_deselected(id); });
 
-  // if nothing provided, generate a unique id based on the object address
-  std::string nid = node_id;
+  if (this->batch_update_depth == 0)
+    this->grow_scene_rect(p_node->sceneBoundingRect());
 
-  if (node_id == "")
-  {
-    std::ostringstream oss;
-    oss << std::to_string((unsigned long long)(void **)p_node);
-    nid = oss.str();
-  }
+  return nid;
+}
 
-  p_node_proxy->set_id(nid);
+void GraphViewer::add_node_placeholder(const NodeRecord  &record,
+                                       const std::string &prefix_id)
+{
+  NodeRecordView placeholder;
+  placeholder.id = this->store_placeholder_string(prefix_id + record.id);
+  placeholder.caption = this->store_placeholder_string(std::string(record.caption));
+  placeholder.is_widget_visible = record.is_widget_visible;
+  placeholder.x = record.x;
+  placeholder.y = record.y;
+
+  this->add_node_placeholder(placeholder);
+}
 
-  return nid;
+void GraphViewer::add_node_placeholder(const NodeRecordView &placeholder)
+{
+  // bucketed on a coarse grid to find the visible placeholders
+  // without scanning all of them
+  QRectF rect = this->get_placeholder_rect(placeholder);
+
+  for (int64_t key : get_grid_keys(rect))
+    this->placeholder_grid[key].push_back(placeholder.id);
+
+  this->node_placeholders[placeholder.id] = placeholder;
+}
+
+void GraphViewer::add_node_record(const NodeRecord &record, const std::string &prefix_id)
+{
+  std::string nid = prefix_id + record.id;
+
+  // nodes are not generated in this class, it is outsourced to the
+  // outter headless nodes manager
+  Q_EMIT this->new_graphics_node_request(nid, QPointF(record.x, record.y));
+
+  if (GraphicsNode *p_node = this->find_node(nid))
+    p_node->record_from(record);
+  else
+    Logger::log()->error("GraphViewer::add_node_record, node {} not created", nid);
+}
+
+void GraphViewer::add_pending_link(const LinkRecordView &record)
+{
+  size_t index = this->pending_links.size();
+
+  this->pending_links_by_node[record.node_out_id].push_back(index);
+  this->pending_links_by_node[record.node_in_id].push_back(index);
+  this->pending_links.push_back(record);
 }
 
 void GraphViewer::add_static_item(QGraphicsItem *item, QPoint window_pos)
 {
-  item->setFlag(QGraphicsItem::ItemIgnoresTransformations, true);
   item->setFlag(QGraphicsItem::ItemIsMovable, false);
 
-  this->add_item(item);
-  this->static_items.push_back(item);
-  this->static_items_positions.push_back(window_pos);
+  // static items live in a small overlay view on top of the viewport
+  // (scene coordinates are viewport pixels), they never enter the
+  // graph scene or its index and are not moved when the view changes.
+  // The overlay is a sibling of the viewport, not a child: scrolling
+  // the viewport (panning) also scrolls its children
+  if (!this->overlay_view)
+  {
+    this->overlay_view = new QGraphicsView(new QGraphicsScene(this), this);
+    this->overlay_view->setFrameShape(QFrame::NoFrame);
+    this->overlay_view->setFocusPolicy(Qt::NoFocus); // keeps the shortcuts
+    this->overlay_view->setStyleSheet("background: transparent");
+    this->overlay_view->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    this->overlay_view->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    this->overlay_view->setRenderHint(QPainter::Antialiasing);
+    this->overlay_view->show();
+  }
+
+  item->setPos(window_pos);
+  this->overlay_view->scene()->addItem(item);
+
+  // the overlay only covers its items, the rest of the viewport still
+  // gets the mouse events
+  QRect  rect = this->overlay_view->scene()->itemsBoundingRect().toAlignedRect();
+  QPoint offset = this->viewport()->geometry().topLeft();
+  this->overlay_view->scene()->setSceneRect(rect);
+  this->overlay_view->setGeometry(rect.translated(offset));
+  this->overlay_view->raise();
 }
 
 void GraphViewer::add_toolbar(QPoint window_pos)
@@ -280,17 +534,122 @@ void GraphViewer::add_toolbar(QPoint window_pos)
   }
 }
 
+void GraphViewer::apply_patch(const GraphPatch &patch)
+{
+  this->begin_batch_update();
+
+  if (patch.clear)
+    this->clear();
+
+  // --- removals
+
+  for (auto &record : patch.removed_links)
+    this->remove_link_record(record);
+
+  for (auto &node_id : patch.removed_nodes)
+    this->remove_node(node_id);
+
+  // --- additions and modifications
+
+  for (auto &record : patch.added_nodes)
+    this->import_node_record(record, "");
+
+  for (auto &record : patch.moved_nodes)
+  {
+    if (GraphicsNode *p_node = this->find_node(record.id))
+      p_node->record_from(record);
+    else if (this->node_placeholders.contains(record.id))
+      this->add_node_placeholder(record, "");
+  }
+
+  for (auto &record : patch.added_links)
+    this->import_link_record(record, "");
+
+  if (patch.groups)
+  {
+    // work on a copy, the registry is modified by each deletion
+    std::vector<GraphicsGroup *> groups_to_delete = this->groups;
+
+    for (GraphicsGroup *p_group : groups_to_delete)
+    {
+      this->unregister_item(p_group);
+      delete p_group;
+    }
+
+    for (auto &record : *patch.groups)
+      this->add_group_record(record);
+  }
+
+  if (patch.current_link_type)
+  {
+    this->current_link_type = (LinkType)*patch.current_link_type;
+
+    for (GraphicsLink *p_link : this->links)
+      p_link->set_link_type(this->current_link_type);
+  }
+
+  this->end_batch_update();
+  this->materialize_visible_nodes();
+}
+
+void GraphViewer::autosave()
+{
+  if (!this->autosave_worker)
+    return;
+
+  // only the record copy runs on the GUI thread, the worker sorts,
+  // serializes and writes the snapshot
+  this->autosave_worker->submit(this->record_to_unsorted(),
+                                this->autosave_fname,
+                                this->is_autosave_compressed);
+}
+
+void GraphViewer::begin_batch_update()
+{
+  if (this->batch_update_depth++ > 0)
+    return;
+
+  // with no index, item insertions are O(1) and the BSP tree is built
+  // once when the index is restored
+  this->batch_index_method = this->scene()->itemIndexMethod();
+  this->scene()->setItemIndexMethod(QGraphicsScene::NoIndex);
+  this->setUpdatesEnabled(false);
+}
+
+void GraphViewer::binary_from(std::string_view   buffer,
+                              bool               clear_existing_content,
+                              const std::string &prefix_id)
+{
+  this->record_from(graph_record_from_binary(buffer), clear_existing_content, prefix_id);
+}
+
+std::string GraphViewer::binary_to() const
+{
+  return graph_record_to_binary(this->record_to());
+}
+
 void GraphViewer::clear()
 {
   std::vector<QGraphicsItem *> items_to_delete = {};
 
   for (QGraphicsItem *item : this->scene()->items())
-    if (!this->is_item_static(item))
-    {
-      item->setSelected(false);
-      this->scene()->removeItem(item);
-      items_to_delete.push_back(item);
-    }
+  {
+    if (item == this->link_batch)
+      continue;
+
+    item->setSelected(false);
+    this->scene()->removeItem(item);
+    items_to_delete.push_back(item);
+  }
+
+  this->nodes_by_id.clear();
+  this->nodes.clear();
+  this->node_slots.clear();
+  this->links.clear();
+  this->link_slots.clear();
+  this->groups.clear();
+  this->release_placeholders();
+  this->reset_serialization_cache();
 
   this->viewport()->update();
 
@@ -298,6 +657,80 @@ void GraphViewer::clear()
     delete item;
 }
 
+void GraphViewer::collect_changes()
+{
+  GraphPatch &patch = this->journal_patch;
+
+  for (GraphicsNode *p_node : this->nodes)
+  {
+    auto [it, is_new] = this->node_fragments.try_emplace(p_node);
+
+    if (!is_new && !p_node->get_is_dirty())
+      continue;
+
+    NodeRecord record = p_node->record_to();
+    it->second = node_record_to_json(record).dump();
+    p_node->set_is_dirty(false);
+
+    if (this->is_journal_enabled)
+      (is_new ? patch.added_nodes : patch.moved_nodes).push_back(std::move(record));
+  }
+
+  // the link type is stored in each link, but it is changed for all
+  // the links at once
+  bool is_link_type_changed = this->serialized_link_type != this->current_link_type;
+
+  if (is_link_type_changed)
+  {
+    this->serialized_link_type = this->current_link_type;
+
+    if (this->is_journal_enabled)
+      patch.current_link_type = this->current_link_type;
+  }
+
+  for (GraphicsLink *p_link : this->links)
+  {
+    auto [it, is_new] = this->link_fragments.try_emplace(p_link);
+
+    if (!is_new && !is_link_type_changed)
+      continue;
+
+    LinkRecord record = p_link->record_to();
+    it->second = link_record_to_json(record).dump();
+
+    if (this->is_journal_enabled && is_new)
+      patch.added_links.push_back(std::move(record));
+  }
+
+  // groups have no id, the whole (short) list is saved again when one
+  // of them changes
+  bool are_groups_dirty = this->are_groups_dirty;
+
+  for (GraphicsGroup *p_group : this->groups)
+    are_groups_dirty |= p_group->get_is_dirty();
+
+  if (are_groups_dirty)
+  {
+    std::vector<GroupRecord> records = {};
+    nlohmann::json           json_group_list = nlohmann::json::array();
+
+    records.reserve(this->groups.size());
+
+    for (GraphicsGroup *p_group : this->groups)
+    {
+      records.push_back(p_group->record_to());
+      json_group_list.push_back(group_record_to_json(records.back()));
+      p_group->set_is_dirty(false);
+    }
+
+    this->groups_fragment = json_group_list.dump();
+    this->are_groups_dirty = false;
+
+    if (this->is_journal_enabled)
+      patch.groups = std::move(records);
+  }
+}
+
 void GraphViewer::contextMenuEvent(QContextMenuEvent *event)
 {
   // --- skip this if there is an item is under the cursor
@@ -454,9 +887,7 @@ void GraphViewer::delete_graphics_link(GraphicsLink *p_link)
                        node_in->get_id(),
                        node_in->get_port_id(port_in));
 
-  node_out->set_is_port_connected(port_out, nullptr);
-  node_in->set_is_port_connected(port_in, nullptr);
-
+  this->unregister_link(p_link);
   delete p_link;
 
   Q_EMIT this->connection_deleted(node_out->get_id(),
@@ -467,23 +898,27 @@ void GraphViewer::delete_graphics_link(GraphicsLink *p_link)
 
 void GraphViewer::delete_graphics_node(GraphicsNode *p_node)
 {
-  Logger::log()->trace("GraphicsNode removing, id: {}", p_node->get_id());
-
   if (!p_node)
   {
     Logger::log()->error("GraphViewer::delete_graphics_node: invalid node provided.");
     return;
   }
 
-  // remove any connected links
-  for (QGraphicsItem *item : this->scene()->items())
-    if (GraphicsLink *p_link = dynamic_cast<GraphicsLink *>(item))
-      if (p_link->get_node_out()->get_id() == p_node->get_id() ||
-          p_link->get_node_in()->get_id() == p_node->get_id())
-        this->delete_graphics_link(p_link);
+  std::string node_id = p_node->get_id();
+
+  Logger::log()->trace("GraphicsNode removing, id: {}", node_id);
+
+  // remove any connected links (work on a copy since the adjacency
+  // list is modified by each deletion)
+  std::vector<GraphicsLink *> node_links = this->get_graphics_links_by_node_id(node_id);
+
+  for (GraphicsLink *p_link : node_links)
+    this->delete_graphics_link(p_link);
 
+  this->unregister_item(p_node);
   delete p_node;
-  Q_EMIT this->node_deleted(p_node->get_id());
+
+  Q_EMIT this->node_deleted(node_id);
 }
 
 void GraphViewer::delete_selected_items()
@@ -493,40 +928,60 @@ void GraphViewer::delete_selected_items()
   if (!scene)
     return;
 
+  // sort the selection by type: selected links are deleted first since
+  // deleting a node also deletes the links still connected to it
+  std::vector<GraphicsNode *>  nodes_to_delete = {};
+  std::vector<GraphicsLink *>  links_to_delete = {};
+  std::vector<QGraphicsItem *> items_to_delete = {};
+
   for (QGraphicsItem *item : scene->selectedItems())
   {
-    // remove item from the scene (if it's not already removed by one
-    // the methods called bellow)
-    if (scene->items().contains(item))
-    {
-      scene->removeItem(item);
+    if (GraphicsNode *p_node = dynamic_cast<GraphicsNode *>(item))
+      nodes_to_delete.push_back(p_node);
+    else if (GraphicsLink *p_link = dynamic_cast<GraphicsLink *>(item))
+      links_to_delete.push_back(p_link);
+    else
+      items_to_delete.push_back(item);
+  }
 
-      if (GraphicsNode *p_node = dynamic_cast<GraphicsNode *>(item))
-        this->delete_graphics_node(p_node);
-      else if (GraphicsLink *p_link = dynamic_cast<GraphicsLink *>(item))
-        this->delete_graphics_link(p_link);
-      else
-      {
-        Logger::log()->trace("item removed");
-        delete item;
-      }
-    }
+  for (GraphicsLink *p_link : links_to_delete)
+  {
+    scene->removeItem(p_link);
+    this->delete_graphics_link(p_link);
   }
-}
 
-void GraphViewer::drawForeground(QPainter *painter, const QRectF &rect)
-{
-  QGraphicsView::drawForeground(painter, rect);
+  for (GraphicsNode *p_node : nodes_to_delete)
+  {
+    scene->removeItem(p_node);
+    this->delete_graphics_node(p_node);
+  }
 
-  for (size_t k = 0; k < this->static_items.size(); k++)
+  for (QGraphicsItem *item : items_to_delete)
   {
-    // Keep the static item at a fixed position
-    QPointF scene_pos = this->mapToScene(this->viewport()->rect().topLeft() +
-                                         this->static_items_positions[k]);
-    this->static_items[k]->setPos(scene_pos);
+    Logger::log()->trace("item removed");
+    scene->removeItem(item);
+    this->unregister_item(item);
+    delete item;
   }
 }
 
+void GraphViewer::end_batch_update()
+{
+  if (this->batch_update_depth == 0 || --this->batch_update_depth > 0)
+    return;
+
+  this->scene()->setItemIndexMethod(this->batch_index_method);
+  this->tune_scene_index();
+
+  QRectF bbox = this->get_items_bounding_rect();
+  for (auto &[_, node] : this->node_placeholders)
+    bbox = bbox.united(this->get_placeholder_rect(node));
+  this->grow_scene_rect(bbox);
+
+  this->setUpdatesEnabled(true);
+  this->viewport()->update();
+}
+
 void GraphViewer::export_to_graphviz(const std::string &fname)
 {
   // after export: to convert, command line: dot export.dot -Tsvg > output.svg
@@ -546,152 +1001,319 @@ void GraphViewer::export_to_graphviz(const std::string &fname)
   file << "node [shape=record];\n";
 
   // Output nodes with their labels
-  for (QGraphicsItem *item : this->scene()->items())
-    if (GraphicsNode *p_node = dynamic_cast<GraphicsNode *>(item))
-      file << p_node->get_id() << " [label=\"" << p_node->get_caption() << "("
-           << p_node->get_id() << ")" << "\"];\n";
+  for (GraphicsNode *p_node : this->nodes)
+    file << p_node->get_id() << " [label=\"" << p_node->get_caption() << "("
+         << p_node->get_id() << ")" << "\"];\n";
 
-  for (QGraphicsItem *item : this->scene()->items())
-    if (GraphicsLink *p_link = dynamic_cast<GraphicsLink *>(item))
-      file << "\"" << p_link->get_node_out()->get_id() << "\" -> \""
-           << p_link->get_node_in()->get_id() << "\" [fontsize=8, label=\""
-           << p_link->get_node_out()->get_port_id(p_link->get_port_out_index()) << " - "
-           << p_link->get_node_in()->get_port_id(p_link->get_port_in_index()) << "\"]"
-           << std::endl;
+  for (GraphicsLink *p_link : this->links)
+    file << "\"" << p_link->get_node_out()->get_id() << "\" -> \""
+         << p_link->get_node_in()->get_id() << "\" [fontsize=8, label=\""
+         << p_link->get_node_out()->get_port_id(p_link->get_port_out_index()) << " - "
+         << p_link->get_node_in()->get_port_id(p_link->get_port_in_index()) << "\"]"
+         << std::endl;
 
   file << "}\n";
 }
 
+GraphicsNode *GraphViewer::find_node(const std::string &id) const
+{
+  auto it = this->nodes_by_id.find(id);
+  return it != this->nodes_by_id.end() ? it->second : nullptr;
+}
+
 GraphicsNode *GraphViewer::get_graphics_node_by_id(const std::string &id)
 {
-  for (QGraphicsItem *item : this->scene()->items())
-    if (GraphicsNode *p_node = dynamic_cast<GraphicsNode *>(item))
-      if (p_node->get_id() == id)
-        return p_node;
+  if (GraphicsNode *p_node = this->find_node(id))
+    return p_node;
 
-  return nullptr;
+  // created on demand if the node is still a placeholder
+  return this->materialize_node(id);
 }
 
-std::vector<std::string> GraphViewer::get_selected_node_ids()
+const std::vector<GraphicsLink *> &GraphViewer::get_graphics_links_by_node_id(
+    const std::string &id) const
 {
-  std::vector<std::string> ids = {};
+  static const std::vector<GraphicsLink *> no_links = {};
+
+  auto it = this->nodes_by_id.find(id);
+  return it != this->nodes_by_id.end() ? it->second->get_connected_links() : no_links;
+}
+
+QRectF GraphViewer::get_items_bounding_rect() const
+{
+  QRectF bbox;
 
   for (QGraphicsItem *item : this->scene()->items())
-    if (GraphicsNode *p_node = dynamic_cast<GraphicsNode *>(item))
-      if (p_node->isSelected())
-        ids.push_back(p_node->get_id());
+    if (item != this->link_batch)
+      bbox |= item->sceneBoundingRect();
 
-  return ids;
+  return bbox;
 }
 
-bool GraphViewer::is_item_static(QGraphicsItem *item)
+QRectF GraphViewer::get_placeholder_rect(const NodeRecordView &record) const
 {
-  return !(std::find(this->static_items.begin(), this->static_items.end(), item) ==
-           this->static_items.end());
+  // the actual size is only known once the node is built, assume a
+  // square node
+  float width = GN_STYLE->node.width;
+  return QRectF(record.x, record.y, width, width);
 }
 
-void GraphViewer::json_from(nlohmann::json     json,
-                            bool               clear_existing_content,
-                            const std::string &prefix_id)
+std::vector<std::string> GraphViewer::get_selected_node_ids()
 {
-  // generate graph from json data
-  if (clear_existing_content)
-  {
-    this->clear();
-    this->id = json["id"];
-    this->current_link_type = json["current_link_type"].get<LinkType>();
-  }
+  std::vector<std::string> ids = {};
 
-  if (!json["groups"].is_null())
-  {
-    for (auto &json_group : json["groups"])
+  for (GraphicsNode *p_node : this->nodes)
+    if (p_node->isSelected())
+      ids.push_back(p_node->get_id());
+
+  return ids;
+}
+
+void GraphViewer::get_selected_nodes_positions(std::vector<std::string> &id_list,
+                                               std::vector<QPointF>     &scene_pos_list)
+{
+  for (GraphicsNode *p_node : this->nodes)
+    if (p_node->isSelected())
     {
-      GraphicsGroup *p_group = new GraphicsGroup();
-      this->add_item(p_group);
-      p_group->json_from(json_group);
+      id_list.push_back(p_node->get_id());
+      scene_pos_list.push_back(p_node->pos());
     }
-  }
+}
 
-  if (!json["nodes"].is_null())
-  {
-    for (auto &json_node : json["nodes"])
-    {
-      std::string nid = prefix_id + json_node["id"].get<std::string>();
+void GraphViewer::grow_scene_rect(const QRectF &rect)
+{
+  if (rect.isEmpty())
+    return;
 
-      float x = json_node["scene_position.x"];
-      float y = json_node["scene_position.y"];
+  QRectF needed = rect.adjusted(-SCENE_RECT_MARGIN,
+                                -SCENE_RECT_MARGIN,
+                                SCENE_RECT_MARGIN,
+                                SCENE_RECT_MARGIN);
 
-      // nodes are not generated in this class, it is outsourced to the
-      // outter headless nodes manager
-      Q_EMIT this->new_graphics_node_request(nid, QPointF(x, y));
+  if (!this->scene()->sceneRect().contains(needed))
+    this->scene()->setSceneRect(this->scene()->sceneRect().united(needed));
+}
 
-      this->get_graphics_node_by_id(nid)->json_from(json_node);
+void GraphViewer::import_link_record(const LinkRecord  &record,
+                                     const std::string &prefix_id)
+{
+  std::string node_out_id = prefix_id + record.node_out_id;
+  std::string node_in_id = prefix_id + record.node_in_id;
 
-      Logger::log()->trace("{}", json_node["caption"].get<std::string>());
-      Logger::log()->trace("{}", this->get_graphics_node_by_id(nid)->get_nports());
-    }
-  }
+  auto out_it = this->node_placeholders.find(node_out_id);
+  auto in_it = this->node_placeholders.find(node_in_id);
 
-  if (!json["links"].is_null())
+  // waits for its nodes if they are not materialized yet
+  if (out_it != this->node_placeholders.end() || in_it != this->node_placeholders.end())
   {
-    for (auto &json_link : json["links"])
+    // the ids of the placeholders are reused, the other strings are
+    // copied to the placeholders storage
+    auto get_node_id = [this](auto it, std::string &&id)
     {
-      std::string node_out_id = prefix_id + json_link["node_out_id"].get<std::string>();
-      std::string node_in_id = prefix_id + json_link["node_in_id"].get<std::string>();
-      std::string port_out_id = json_link["port_out_id"];
-      std::string port_in_id = json_link["port_in_id"];
+      if (it != this->node_placeholders.end())
+        return it->first;
+      return this->store_placeholder_string(std::move(id));
+    };
+
+    LinkRecordView pending;
+    pending.node_out_id = get_node_id(out_it, std::move(node_out_id));
+    pending.port_out_id = this->store_placeholder_string(std::string(record.port_out_id));
+    pending.node_in_id = get_node_id(in_it, std::move(node_in_id));
+    pending.port_in_id = this->store_placeholder_string(std::string(record.port_in_id));
+    pending.link_type = record.link_type;
+
+    this->add_pending_link(pending);
+  }
+  else
+    this->add_link_record(record, prefix_id);
+}
 
-      // same here, the graphic links are generated but the data
-      // connection itself is outsourced to the outter headless nodes
-      // manager
-      this->temp_link = new GraphicsLink(QColor(0, 0, 0, 0), this->current_link_type);
-      this->scene()->addItem(this->temp_link);
+void GraphViewer::import_node_record(const NodeRecord  &record,
+                                     const std::string &prefix_id)
+{
+  if (this->is_lazy_materialization)
+    this->add_node_placeholder(record, prefix_id);
+  else
+    this->add_node_record(record, prefix_id);
+}
 
-      GraphicsNode *from_node = this->get_graphics_node_by_id(node_out_id);
-      GraphicsNode *to_node = this->get_graphics_node_by_id(node_in_id);
+void GraphViewer::json_from(const nlohmann::json &json,
+                            bool                  clear_existing_content,
+                            const std::string    &prefix_id)
+{
+  this->record_from(graph_record_from_json(json), clear_existing_content, prefix_id);
+}
 
-      if (from_node && to_node)
-      {
-        int port_from_index = from_node->get_port_index(port_out_id);
-        int port_to_index = to_node->get_port_index(port_in_id);
+void GraphViewer::json_from(std::istream      &is,
+                            bool               clear_existing_content,
+                            const std::string &prefix_id)
+{
+  this->begin_batch_update();
 
-        this->on_connection_finished(from_node, port_from_index, to_node, port_to_index);
-      }
-      else
-        Logger::log()->error(
-            "GraphViewer::json_from, nodes instance cannot be found, IDs: {} and/or {}",
-            node_out_id,
-            node_in_id);
-    }
+  if (clear_existing_content)
+    this->clear();
+
+  // links read after the nodes (see graph_record_dump) are created
+  // right away, the ones coming first (nlohmann sorted keys) are kept
+  // aside until all the nodes exist
+  std::vector<LinkRecord> pending_links = {};
+  bool                    has_nodes = false;
+
+  GraphJsonSaxCallbacks callbacks;
+
+  callbacks.on_group = [this](GroupRecord &&record) { this->add_group_record(record); };
+
+  callbacks.on_link = [this, &pending_links, &has_nodes, &prefix_id](LinkRecord &&record)
+  {
+    if (has_nodes)
+      this->import_link_record(record, prefix_id);
+    else
+      pending_links.push_back(std::move(record));
+  };
+
+  callbacks.on_node = [this, &has_nodes, &prefix_id](NodeRecord &&record)
+  {
+    has_nodes = true;
+    this->import_node_record(record, prefix_id);
+  };
+
+  if (clear_existing_content)
+  {
+    callbacks.on_id = [this](const std::string &id) { this->id = id; };
+    callbacks.on_current_link_type = [this](int link_type)
+    { this->current_link_type = (LinkType)link_type; };
   }
+
+  try
+  {
+    read_graph_json_sax(is, callbacks);
+  }
+  catch (...)
+  {
+    this->end_batch_update();
+    throw;
+  }
+
+  for (auto &link : pending_links)
+    this->import_link_record(link, prefix_id);
+
+  this->end_batch_update();
+  this->materialize_visible_nodes();
+}
+
+void GraphViewer::json_from_file(const std::string &fname,
+                                 bool               clear_existing_content,
+                                 const std::string &prefix_id)
+{
+  std::ifstream file(fname);
+
+  if (!file.is_open())
+    throw std::runtime_error("Failed to open file: " + fname);
+
+  this->json_from(file, clear_existing_content, prefix_id);
 }
 
 nlohmann::json GraphViewer::json_to() const
 {
-  nlohmann::json json;
+  return graph_record_to_json(this->record_to());
+}
+
+std::string GraphViewer::json_dump_incremental()
+{
+  // the placeholders are not tracked, plain dump until all the nodes
+  // are materialized
+  if (!this->node_placeholders.empty())
+    return graph_record_dump(this->record_to());
 
-  json["id"] = this->id;
-  json["current_link_type"] = this->current_link_type;
+  this->collect_changes();
 
-  std::vector<nlohmann::json> json_node_list = {};
-  std::vector<nlohmann::json> json_link_list = {};
-  std::vector<nlohmann::json> json_group_list = {};
+  // assemble the cached fragments, same layout as graph_record_dump
+  // (nodes before links)
+  size_t size = this->groups_fragment.size() + 256;
 
-  for (QGraphicsItem *item : this->scene()->items())
+  for (auto &[_, fragment] : this->node_fragments)
+    size += fragment.size() + 1;
+
+  for (auto &[_, fragment] : this->link_fragments)
+    size += fragment.size() + 1;
+
+  std::string text;
+  text.reserve(size);
+
+  text += "{\"current_link_type\":" + std::to_string((int)this->current_link_type);
+  text += ",\"groups\":" + this->groups_fragment;
+  text += ",\"id\":" + nlohmann::json(this->id).dump();
+
+  // same item order as record_to, sorted by id since the registry
+  // order changes with the removals
+  std::vector<std::pair<LinkRecord, GraphicsLink *>> sorted_links = {};
+  sorted_links.reserve(this->links.size());
+
+  for (GraphicsLink *p_link : this->links)
+    sorted_links.emplace_back(p_link->record_to(), p_link);
+
+  std::sort(sorted_links.begin(),
+            sorted_links.end(),
+            [](const auto &a, const auto &b)
+            { return is_link_record_before(a.first, b.first); });
+
+  std::vector<std::pair<std::string, GraphicsNode *>> sorted_nodes = {};
+  sorted_nodes.reserve(this->nodes.size());
+
+  for (GraphicsNode *p_node : this->nodes)
+    sorted_nodes.emplace_back(p_node->get_id(), p_node);
+
+  std::sort(sorted_nodes.begin(), sorted_nodes.end());
+
+  text += ",\"nodes\":[";
+  for (size_t k = 0; k < sorted_nodes.size(); k++)
   {
-    if (GraphicsNode *p_node = dynamic_cast<GraphicsNode *>(item))
-      json_node_list.push_back(p_node->json_to());
-    else if (GraphicsLink *p_link = dynamic_cast<GraphicsLink *>(item))
-      json_link_list.push_back(p_link->json_to());
-    else if (GraphicsGroup *p_group = dynamic_cast<GraphicsGroup *>(item))
-      json_group_list.push_back(p_group->json_to());
+    if (k > 0)
+      text += ',';
+    text += this->node_fragments.at(sorted_nodes[k].second);
+  }
+
+  text += "],\"links\":[";
+  for (size_t k = 0; k < sorted_links.size(); k++)
+  {
+    if (k > 0)
+      text += ',';
+    text += this->link_fragments.at(sorted_links[k].second);
   }
 
-  json["nodes"] = json_node_list;
-  json["links"] = json_link_list;
-  json["groups"] = json_group_list;
+  text += "]}";
+
+  return text;
+}
+
+void GraphViewer::journal_link_removed(GraphicsLink *p_link)
+{
+  // links never serialized are not part of the saved state
+  if (this->link_fragments.erase(p_link) == 0 || !this->is_journal_enabled)
+    return;
+
+  LinkRecord record = p_link->record_to();
+
+  // a link added since the last journal entry just disappears from
+  // the patch
+  if (std::erase_if(this->journal_patch.added_links,
+                    [&record](const LinkRecord &other)
+                    { return is_same_link(record, other); }) == 0)
+    this->journal_patch.removed_links.push_back(std::move(record));
+}
 
-  return json;
+void GraphViewer::journal_node_removed(GraphicsNode *p_node)
+{
+  if (this->node_fragments.erase(p_node) == 0 || !this->is_journal_enabled)
+    return;
+
+  std::string id = p_node->get_id();
+  auto        is_same_node = [&id](const NodeRecord &record) { return record.id == id; };
+
+  std::erase_if(this->journal_patch.moved_nodes, is_same_node);
+
+  if (std::erase_if(this->journal_patch.added_nodes, is_same_node) == 0)
+    this->journal_patch.removed_nodes.push_back(id);
 }
 
 void GraphViewer::keyPressEvent(QKeyEvent *event)
@@ -716,14 +1338,7 @@ void GraphViewer::keyReleaseEvent(QKeyEvent *event)
   {
     std::vector<std::string> id_list = {};
     std::vector<QPointF>     scene_pos_list = {};
-
-    for (QGraphicsItem *item : this->scene()->items())
-      if (GraphicsNode *p_node = dynamic_cast<GraphicsNode *>(item))
-        if (p_node->isSelected())
-        {
-          id_list.push_back(p_node->get_id());
-          scene_pos_list.push_back(p_node->pos());
-        }
+    this->get_selected_nodes_positions(id_list, scene_pos_list);
 
     if (id_list.size())
       Q_EMIT this->nodes_copy_request(id_list, scene_pos_list);
@@ -732,14 +1347,7 @@ void GraphViewer::keyReleaseEvent(QKeyEvent *event)
   {
     std::vector<std::string> id_list = {};
     std::vector<QPointF>     scene_pos_list = {};
-
-    for (QGraphicsItem *item : this->scene()->items())
-      if (GraphicsNode *p_node = dynamic_cast<GraphicsNode *>(item))
-        if (p_node->isSelected())
-        {
-          id_list.push_back(p_node->get_id());
-          scene_pos_list.push_back(p_node->pos());
-        }
+    this->get_selected_nodes_positions(id_list, scene_pos_list);
 
     if (id_list.size())
       Q_EMIT this->nodes_duplicate_request(id_list, scene_pos_list);
@@ -787,6 +1395,321 @@ void GraphViewer::keyReleaseEvent(QKeyEvent *event)
   QGraphicsView::keyReleaseEvent(event);
 }
 
+void GraphViewer::load_file(const std::string &fname,
+                            bool               clear_existing_content,
+                            const std::string &prefix_id)
+{
+  std::ifstream file(fname, std::ios::binary);
+
+  if (!file.is_open())
+    throw std::runtime_error("Failed to open file: " + fname);
+
+  // plain JSON is streamed, the other formats are read at once
+  char magic[4] = {};
+  file.read(magic, 4);
+  std::string_view header(magic, (size_t)file.gcount());
+
+  file.clear();
+  file.seekg(0);
+
+  if (!is_graph_compressed(header) && !is_graph_binary(header))
+  {
+    this->json_from(file, clear_existing_content, prefix_id);
+    return;
+  }
+
+  std::string buffer((std::istreambuf_iterator<char>(file)),
+                     std::istreambuf_iterator<char>());
+
+  if (is_graph_compressed(buffer))
+    buffer = graph_decompress(buffer);
+
+  if (is_graph_binary(buffer))
+    this->binary_from(buffer, clear_existing_content, prefix_id);
+  else
+  {
+    MemoryStreamBuffer stream_buffer(buffer);
+    std::istream       is(&stream_buffer);
+
+    this->json_from(is, clear_existing_content, prefix_id);
+  }
+}
+
+void GraphViewer::load_mapped(const std::string &fname)
+{
+  auto file = std::make_unique<QFile>(QString::fromStdString(fname));
+
+  if (!file->open(QIODevice::ReadOnly))
+    throw std::runtime_error("Failed to open file: " + fname);
+
+  // the mapping is released with 'file', unless the placeholders of a
+  // binary file keep it (see release_placeholders)
+  uchar *data = file->size() > 0 ? file->map(0, file->size()) : nullptr;
+
+  if (!data)
+    throw std::runtime_error("Failed to map file: " + fname);
+
+  std::string_view buffer((const char *)data, (size_t)file->size());
+
+  // a compressed file cannot be read in place, it is inflated first
+  std::unique_ptr<std::string> decompressed;
+
+  if (is_graph_compressed(buffer))
+  {
+    decompressed = std::make_unique<std::string>(graph_decompress(buffer));
+    buffer = *decompressed;
+  }
+
+  // nodes are only materialized once visible, whatever the current
+  // setting
+  bool is_lazy_backup = this->is_lazy_materialization;
+  this->is_lazy_materialization = true;
+
+  this->begin_batch_update();
+
+  try
+  {
+    if (is_graph_binary(buffer))
+    {
+      // records are read in place and the placeholders are views on
+      // the buffer, which is kept until they are all materialized: the
+      // strings are only copied once a node is created
+      GraphBinaryView view(buffer);
+
+      this->clear();
+      this->placeholder_file = std::move(file);
+      this->placeholder_buffer = std::move(decompressed);
+
+      this->id = std::string(view.get_id());
+      this->current_link_type = (LinkType)view.get_current_link_type();
+
+      this->groups.reserve(view.get_ngroups());
+      this->node_placeholders.reserve(view.get_nnodes());
+      this->pending_links.reserve(view.get_nlinks());
+
+      for (size_t k = 0; k < view.get_ngroups(); k++)
+        this->add_group_record(view.get_group(k));
+
+      for (size_t k = 0; k < view.get_nnodes(); k++)
+        this->add_node_placeholder(view.get_node(k));
+
+      // all the nodes are placeholders, so are the links
+      for (size_t k = 0; k < view.get_nlinks(); k++)
+        this->add_pending_link(view.get_link(k));
+    }
+    else
+    {
+      // JSON, streamed from the mapped bytes
+      MemoryStreamBuffer stream_buffer(buffer);
+      std::istream       is(&stream_buffer);
+
+      this->json_from(is);
+    }
+  }
+  catch (...)
+  {
+    this->is_lazy_materialization = is_lazy_backup;
+    this->end_batch_update();
+    throw;
+  }
+
+  this->is_lazy_materialization = is_lazy_backup;
+  this->end_batch_update();
+  this->materialize_visible_nodes();
+}
+
+void GraphViewer::load_with_journal(const std::string &fname)
+{
+  std::ifstream file(fname, std::ios::binary);
+
+  if (!file.is_open())
+    throw std::runtime_error("Failed to open file: " + fname);
+
+  // kept in memory to check the journal stamp
+  std::string buffer((std::istreambuf_iterator<char>(file)),
+                     std::istreambuf_iterator<char>());
+
+  // base state, streamed into records
+  GraphRecord           record;
+  GraphJsonSaxCallbacks callbacks;
+
+  callbacks.on_id = [&record](const std::string &id) { record.id = id; };
+  callbacks.on_current_link_type = [&record](int link_type)
+  { record.current_link_type = link_type; };
+  callbacks.on_group = [&record](GroupRecord &&group)
+  { record.groups.push_back(std::move(group)); };
+  callbacks.on_link = [&record](LinkRecord &&link)
+  { record.links.push_back(std::move(link)); };
+  callbacks.on_node = [&record](NodeRecord &&node)
+  { record.nodes.push_back(std::move(node)); };
+
+  MemoryStreamBuffer stream_buffer(buffer);
+  std::istream       is(&stream_buffer);
+  read_graph_json_sax(is, callbacks);
+
+  // replay the journal, a truncated last line (interrupted save) only
+  // drops that entry. A journal stamped for another base (save_full
+  // interrupted between the two writes) is already part of the base
+  std::ifstream journal(fname + ".journal");
+
+  if (journal.is_open())
+  {
+    try
+    {
+      std::string header;
+      std::getline(journal, header);
+
+      if (nlohmann::json::parse(header).value("base", "") == get_journal_stamp(buffer))
+        apply_graph_journal(record, journal);
+      else
+        Logger::log()->warn("GraphViewer::load_with_journal, journal of another base "
+                            "file ignored: {}",
+                            fname + ".journal");
+    }
+    catch (const nlohmann::json::exception &e)
+    {
+      Logger::log()->error("GraphViewer::load_with_journal, journal: {}", e.what());
+    }
+  }
+
+  this->is_journal_enabled = false;
+  this->record_from(record);
+
+  // the loaded state becomes the reference of the next journal entries
+  this->collect_changes();
+  this->journal_patch = GraphPatch();
+  this->is_journal_enabled = true;
+}
+
+void GraphViewer::materialize_all_nodes()
+{
+  if (this->node_placeholders.empty())
+    return;
+
+  std::vector<std::string> ids = {};
+  ids.reserve(this->node_placeholders.size());
+
+  for (auto &[id, _] : this->node_placeholders)
+    ids.emplace_back(id);
+
+  this->begin_batch_update();
+
+  for (auto &id : ids)
+    this->materialize_node(id);
+
+  this->end_batch_update();
+}
+
+GraphicsNode *GraphViewer::materialize_node(const std::string &id)
+{
+  auto it = this->node_placeholders.find(id);
+
+  if (it == this->node_placeholders.end())
+    return nullptr;
+
+  // removed first, the node creation goes through the registry lookups
+  NodeRecord record = it->second.to_record();
+  this->node_placeholders.erase(it);
+
+  this->add_node_record(record, "");
+
+  GraphicsNode *p_node = this->find_node(id);
+
+  if (!p_node)
+    return nullptr;
+
+  // the node belongs to the loaded state, it is not a change to save
+  this->node_fragments[p_node] = node_record_to_json(p_node->record_to()).dump();
+  p_node->set_is_dirty(false);
+
+  // links waiting for this node, created if the other end exists
+  auto lit = this->pending_links_by_node.find(id);
+
+  if (lit != this->pending_links_by_node.end())
+  {
+    std::vector<size_t> indices = std::move(lit->second);
+    this->pending_links_by_node.erase(lit);
+
+    for (size_t index : indices)
+    {
+      std::optional<LinkRecordView> &link = this->pending_links[index];
+
+      if (!link)
+        continue;
+
+      LinkRecord link_record = link->to_record();
+
+      if (!this->find_node(link_record.node_out_id) ||
+          !this->find_node(link_record.node_in_id))
+        continue;
+
+      size_t nlinks = this->links.size();
+      this->add_link_record(link_record, "");
+
+      if (this->links.size() > nlinks)
+      {
+        GraphicsLink *p_link = this->links.back();
+        this->link_fragments[p_link] = link_record_to_json(p_link->record_to()).dump();
+      }
+
+      link.reset();
+    }
+  }
+
+  if (this->node_placeholders.empty())
+    this->release_placeholders();
+
+  return p_node;
+}
+
+void GraphViewer::materialize_visible_nodes()
+{
+  if (this->node_placeholders.empty())
+    return;
+
+  // visible area with a margin, so that nodes are ready when panning
+  QRectF visible = this->mapToScene(this->viewport()->rect()).boundingRect();
+  visible.adjust(-0.5f * visible.width(),
+                 -0.5f * visible.height(),
+                 0.5f * visible.width(),
+                 0.5f * visible.height());
+
+  std::vector<std::string> ids = {};
+
+  for (int64_t key : get_grid_keys(visible))
+  {
+    auto it = this->placeholder_grid.find(key);
+    if (it == this->placeholder_grid.end())
+      continue;
+
+    // drop the ids of the nodes already materialized
+    std::erase_if(it->second,
+                  [this](std::string_view id)
+                  { return !this->node_placeholders.contains(id); });
+
+    for (auto &id : it->second)
+      if (visible.intersects(this->get_placeholder_rect(this->node_placeholders.at(id))))
+        ids.emplace_back(id);
+
+    if (it->second.empty())
+      this->placeholder_grid.erase(it);
+  }
+
+  // a node spanning several cells is listed more than once
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+  if (ids.empty())
+    return;
+
+  this->begin_batch_update();
+
+  for (auto &id : ids)
+    this->materialize_node(id);
+
+  this->end_batch_update();
+}
+
 void GraphViewer::mouseMoveEvent(QMouseEvent *event)
 {
   if (this->temp_link)
@@ -794,6 +1717,9 @@ void GraphViewer::mouseMoveEvent(QMouseEvent *event)
     // Update the end of the temporary cubic spline to follow the mouse
     QPointF end_pos = mapToScene(event->pos());
     this->temp_link->set_endpoints(this->temp_link->path().pointAtPercent(0), end_pos);
+
+    if (this->source_node)
+      this->update_connection_target(end_pos);
   }
 
   QGraphicsView::mouseMoveEvent(event);
@@ -821,6 +1747,21 @@ void GraphViewer::mousePressEvent(QMouseEvent *event)
   }
 
   QGraphicsView::mousePressEvent(event);
+
+  // dragging a large selection moves many items at each mouse move,
+  // cheaper without maintaining the scene index meanwhile
+  if (event->button() == Qt::LeftButton && !this->is_bulk_moving &&
+      this->batch_update_depth == 0 && this->scene()->mouseGrabberItem())
+  {
+    int nselected = (int)this->scene()->selectedItems().size();
+
+    if (nselected >= GN_STYLE->viewer.bulk_move_threshold)
+    {
+      this->is_bulk_moving = true;
+      this->bulk_move_index_method = this->scene()->itemIndexMethod();
+      this->scene()->setItemIndexMethod(QGraphicsScene::NoIndex);
+    }
+  }
 }
 
 void GraphViewer::mouseReleaseEvent(QMouseEvent *event)
@@ -829,16 +1770,34 @@ void GraphViewer::mouseReleaseEvent(QMouseEvent *event)
     this->setDragMode(QGraphicsView::NoDrag);
 
   QGraphicsView::mouseReleaseEvent(event);
+
+  if (event->button() == Qt::LeftButton)
+  {
+    if (this->is_bulk_moving)
+    {
+      this->is_bulk_moving = false;
+      this->scene()->setItemIndexMethod(this->bulk_move_index_method);
+      this->tune_scene_index();
+    }
+
+    // moved items may have left the scene rect
+    QRectF bbox;
+    for (QGraphicsItem *item : this->scene()->selectedItems())
+      bbox = bbox.united(item->sceneBoundingRect());
+    this->grow_scene_rect(bbox);
+  }
 }
 
 void GraphViewer::on_compute_finished(const std::string &id)
 {
-  this->get_graphics_node_by_id(id)->on_compute_started();
+  if (GraphicsNode *p_node = this->find_node(id))
+    p_node->on_compute_started();
 }
 
 void GraphViewer::on_compute_started(const std::string &id)
 {
-  this->get_graphics_node_by_id(id)->on_compute_finished();
+  if (GraphicsNode *p_node = this->find_node(id))
+    p_node->on_compute_finished();
 }
 
 void GraphViewer::on_connection_dropped(GraphicsNode *from,
@@ -860,6 +1819,8 @@ void GraphViewer::on_connection_dropped(GraphicsNode *from,
                                     from->get_port_id(port_index),
                                     scene_pos);
   }
+
+  this->reset_connection_drag();
 }
 
 void GraphViewer::on_connection_finished(GraphicsNode *from_node,
@@ -897,8 +1858,7 @@ void GraphViewer::on_connection_finished(GraphicsNode *from_node,
         int port_out = this->temp_link->get_port_out_index();
         int port_in = this->temp_link->get_port_in_index();
 
-        node_out->set_is_port_connected(port_out, this->temp_link);
-        node_in->set_is_port_connected(port_in, this->temp_link);
+        this->register_link(this->temp_link);
 
         Logger::log()->trace("GraphViewer::on_connection_finished, {}:{} -> {}:{}",
                              node_out->get_id(),
@@ -925,16 +1885,24 @@ void GraphViewer::on_connection_finished(GraphicsNode *from_node,
     }
   }
 
-  this->source_node = nullptr;
+  this->reset_connection_drag();
 }
 
 void GraphViewer::on_connection_started(GraphicsNode *from_node, int port_index)
 {
   this->source_node = from_node;
+  this->source_port_index = port_index;
+  this->target_node = nullptr;
+
+  // dim the ports which cannot accept the link, done once for the
+  // whole drag
+  int data_type_id = from_node->get_data_type_id(port_index);
+
+  for (GraphicsNode *p_node : this->nodes)
+    p_node->set_data_type_connecting(data_type_id);
 
-  this->temp_link = new GraphicsLink(
-      get_color_from_data_type(from_node->get_data_type(port_index)),
-      this->current_link_type);
+  this->temp_link = new GraphicsLink(get_color_from_data_type_id(data_type_id),
+                                     this->current_link_type);
 
   QPointF port_pos = from_node->scenePos() +
                      from_node->get_geometry_ref()->port_rects[port_index].center();
@@ -981,26 +1949,350 @@ void GraphViewer::on_update_started()
   }
 }
 
+void GraphViewer::paintEvent(QPaintEvent *event)
+{
+  const bool show_stats = GN_STYLE->viewer.show_render_stats;
+
+  // the items count their own paint calls during the frame
+  if (show_stats)
+  {
+    GraphicsNode::reset_paint_count();
+    GraphicsLink::reset_paint_count();
+    this->link_batch->reset_paint_count();
+  }
+
+  QGraphicsView::paintEvent(event);
+
+  if (!show_stats)
+    return;
+
+  // screen space strip at the bottom of the viewport, on top of the
+  // scene
+  int   text_height = this->viewport()->fontMetrics().height();
+  QRect stats_rect = QRect(10,
+                           this->viewport()->height() - 10 - text_height,
+                           this->viewport()->width() - 20,
+                           text_height);
+
+  // repaint requested below for the strip alone, the items drawn under
+  // it are not a frame
+  if (event->region() != QRegion(stats_rect))
+  {
+    RenderStats stats;
+
+    stats.painted_nodes = GraphicsNode::get_paint_count();
+    stats.painted_links = GraphicsLink::get_paint_count() +
+                          this->link_batch->get_paint_count();
+    stats.culled_nodes = (int)(this->nodes.size() + this->node_placeholders.size()) -
+                         stats.painted_nodes;
+    stats.culled_links = (int)this->links.size() - stats.painted_links;
+
+    this->render_stats = stats;
+  }
+
+  // a partial repaint (see Style::Viewer::viewport_update_mode) missing
+  // the strip would leave stale numbers, only the strip is refreshed
+  if (!event->region().contains(stats_rect))
+  {
+    this->viewport()->update(stats_rect);
+    return;
+  }
+
+  QString text = QString("nodes: %1 painted, %2 culled - links: %3 painted, %4 culled")
+                     .arg(this->render_stats.painted_nodes)
+                     .arg(this->render_stats.culled_nodes)
+                     .arg(this->render_stats.painted_links)
+                     .arg(this->render_stats.culled_links);
+
+  QPainter painter(this->viewport());
+  painter.setPen(GN_STYLE->viewer.color_toolbar);
+  painter.drawText(stats_rect, Qt::AlignRight | Qt::AlignBottom, text);
+}
+
+void GraphViewer::paste_binary(std::string_view   buffer,
+                               const std::string &prefix_id,
+                               QPointF            delta)
+{
+  GraphRecord record = graph_record_from_binary(buffer);
+
+  for (auto &node : record.nodes)
+  {
+    node.x += delta.x();
+    node.y += delta.y();
+  }
+
+  for (auto &group : record.groups)
+  {
+    group.x += delta.x();
+    group.y += delta.y();
+  }
+
+  this->record_from(record, false, prefix_id);
+
+  // the pasted nodes replace the current selection
+  this->scene()->clearSelection();
+
+  for (auto &node : record.nodes)
+    if (GraphicsNode *p_node = this->find_node(prefix_id + node.id))
+      p_node->setSelected(true);
+}
+
+void GraphViewer::record_from(const GraphRecord &record,
+                              bool               clear_existing_content,
+                              const std::string &prefix_id)
+{
+  // everything is created in one pass with the scene index and the
+  // viewport updates suspended
+  this->begin_batch_update();
+
+  // generate graph from the record
+  if (clear_existing_content)
+  {
+    this->clear();
+    this->id = record.id;
+    this->current_link_type = (LinkType)record.current_link_type;
+  }
+
+  this->groups.reserve(this->groups.size() + record.groups.size());
+  this->nodes.reserve(this->nodes.size() + record.nodes.size());
+  this->nodes_by_id.reserve(this->nodes_by_id.size() + record.nodes.size());
+  this->node_slots.reserve(this->node_slots.size() + record.nodes.size());
+  this->links.reserve(this->links.size() + record.links.size());
+  this->link_slots.reserve(this->link_slots.size() + record.links.size());
+
+  for (auto &group : record.groups)
+    this->add_group_record(group);
+
+  for (auto &node : record.nodes)
+    this->import_node_record(node, prefix_id);
+
+  for (auto &link : record.links)
+    this->import_link_record(link, prefix_id);
+
+  this->end_batch_update();
+  this->materialize_visible_nodes();
+}
+
+GraphRecord GraphViewer::record_to() const
+{
+  GraphRecord record = this->record_to_unsorted();
+  sort_graph_record(record);
+  return record;
+}
+
+GraphRecord GraphViewer::record_to_unsorted() const
+{
+  GraphRecord record;
+
+  record.id = this->id;
+  record.current_link_type = this->current_link_type;
+
+  record.nodes.reserve(this->nodes.size());
+  record.links.reserve(this->links.size());
+  record.groups.reserve(this->groups.size());
+
+  for (GraphicsNode *p_node : this->nodes)
+    record.nodes.push_back(p_node->record_to());
+
+  for (GraphicsLink *p_link : this->links)
+    record.links.push_back(p_link->record_to());
+
+  for (GraphicsGroup *p_group : this->groups)
+    record.groups.push_back(p_group->record_to());
+
+  // nodes and links not materialized yet
+  for (auto &[_, node] : this->node_placeholders)
+    record.nodes.push_back(node.to_record());
+
+  auto is_known = [this](const std::string &id)
+  { return this->nodes_by_id.contains(id) || this->node_placeholders.contains(id); };
+
+  for (auto &link : this->pending_links)
+    if (link)
+    {
+      LinkRecord link_record = link->to_record();
+
+      if (is_known(link_record.node_out_id) && is_known(link_record.node_in_id))
+        record.links.push_back(std::move(link_record));
+    }
+
+  return record;
+}
+
+void GraphViewer::record_update(const GraphRecord &record)
+{
+  this->id = record.id;
+  this->apply_patch(graph_diff(this->record_to(), record));
+}
+
+void GraphViewer::register_item(QGraphicsItem *item)
+{
+  if (GraphicsNode *p_node = dynamic_cast<GraphicsNode *>(item))
+  {
+    this->node_slots[p_node] = this->nodes.size();
+    this->nodes.push_back(p_node);
+    this->nodes_by_id[p_node->get_id()] = p_node;
+  }
+  else if (GraphicsLink *p_link = dynamic_cast<GraphicsLink *>(item))
+    this->register_link(p_link);
+  else if (GraphicsGroup *p_group = dynamic_cast<GraphicsGroup *>(item))
+  {
+    this->groups.push_back(p_group);
+    this->are_groups_dirty = true;
+  }
+}
+
+void GraphViewer::register_link(GraphicsLink *p_link)
+{
+  // only links fully connected are part of the graph
+  if (!p_link->get_node_out() || !p_link->get_node_in())
+    return;
+
+  p_link->set_is_batched(GN_STYLE->link.batched_rendering);
+
+  this->link_slots[p_link] = this->links.size();
+  this->links.push_back(p_link);
+  p_link->get_node_out()->add_connected_link(p_link);
+  p_link->get_node_in()->add_connected_link(p_link);
+}
+
+void GraphViewer::release_placeholders()
+{
+  // the views first, then the storage they refer to
+  this->node_placeholders.clear();
+  this->placeholder_grid.clear();
+  this->pending_links.clear();
+  this->pending_links_by_node.clear();
+  this->placeholder_strings.clear();
+  this->placeholder_buffer.reset();
+  this->placeholder_file.reset();
+}
+
+void GraphViewer::remove_link_record(const LinkRecord &record)
+{
+  // link waiting for a placeholder
+  auto it = this->pending_links_by_node.find(record.node_out_id);
+
+  if (it != this->pending_links_by_node.end())
+    for (size_t index : it->second)
+    {
+      std::optional<LinkRecordView> &link = this->pending_links[index];
+      if (link && is_same_link(link->to_record(), record))
+        link.reset();
+    }
+
+  GraphicsNode *p_node = this->find_node(record.node_out_id);
+
+  if (!p_node)
+    return;
+
+  for (GraphicsLink *p_link : p_node->get_connected_links())
+    if (p_link->get_node_out() == p_node && is_same_link(p_link->record_to(), record))
+    {
+      this->delete_graphics_link(p_link);
+      return;
+    }
+}
+
 void GraphViewer::remove_node(const std::string &node_id)
 {
-  for (QGraphicsItem *item : this->scene()->items())
-    if (GraphicsNode *p_node = dynamic_cast<GraphicsNode *>(item))
-      if (p_node->get_id() == node_id)
-        this->delete_graphics_node(p_node);
+  // a node not materialized yet is simply forgotten
+  if (this->node_placeholders.erase(node_id) > 0)
+  {
+    this->pending_links_by_node.erase(node_id);
+
+    if (this->node_placeholders.empty())
+      this->release_placeholders();
+  }
+  else if (GraphicsNode *p_node = this->find_node(node_id))
+    this->delete_graphics_node(p_node);
+}
+
+void GraphViewer::reset_connection_drag()
+{
+  // nothing to clean-up for links created programmatically (no drag)
+  if (!this->source_node)
+    return;
+
+  for (GraphicsNode *p_node : this->nodes)
+    p_node->reset_connection_state();
+
+  this->source_node = nullptr;
+  this->source_port_index = -1;
+  this->target_node = nullptr;
+}
+
+void GraphViewer::reset_serialization_cache()
+{
+  this->node_fragments.clear();
+  this->link_fragments.clear();
+  this->are_groups_dirty = true;
+  this->serialized_link_type = -1;
+
+  // everything will be added again in the next journal entry
+  if (this->is_journal_enabled)
+  {
+    this->journal_patch = GraphPatch();
+    this->journal_patch.clear = true;
+  }
 }
 
 void GraphViewer::resizeEvent(QResizeEvent *event)
 {
   QGraphicsView::resizeEvent(event);
 
-  for (size_t k = 0; k < this->static_items.size(); k++)
+  // the viewport may have moved within the view (frame, margins)
+  if (this->overlay_view)
   {
-    // Map the desired position in the view to the scene coordinates
-    // and set the position relative to the view
-    QPointF scene_pos = this->mapToScene(this->viewport()->rect().topLeft() +
-                                         this->static_items_positions[k]);
-    this->static_items[k]->setPos(scene_pos);
+    QPoint offset = this->viewport()->geometry().topLeft();
+    QRect  rect = this->overlay_view->sceneRect().toAlignedRect();
+    this->overlay_view->setGeometry(rect.translated(offset));
   }
+
+  this->schedule_materialization();
+}
+
+void GraphViewer::save_compressed(const std::string &fname, bool binary, int level)
+{
+  std::string buffer = binary ? this->binary_to() : graph_record_dump(this->record_to());
+  write_file_atomic(fname, graph_compress(buffer, level));
+}
+
+void GraphViewer::save_full(const std::string &fname)
+{
+  // the base is written first, until the journal is replaced the old
+  // one is ignored at loading since its stamp does not match
+  std::string    buffer = this->json_dump_incremental();
+  nlohmann::json header = {{"base", get_journal_stamp(buffer)}};
+
+  write_file_atomic(fname, buffer);
+  write_file_atomic(fname + ".journal", header.dump() + "\n");
+
+  this->journal_patch = GraphPatch();
+  this->is_journal_enabled = true;
+}
+
+void GraphViewer::save_journal(const std::string &fname)
+{
+  if (!this->is_journal_enabled || !this->node_placeholders.empty())
+  {
+    this->save_full(fname);
+    return;
+  }
+
+  this->collect_changes();
+
+  if (this->journal_patch.is_empty())
+    return;
+
+  std::ofstream file(fname + ".journal", std::ios::app);
+
+  if (!file.is_open())
+    throw std::runtime_error("Failed to open file: " + fname + ".journal");
+
+  file << graph_patch_to_json(this->journal_patch).dump() << "\n";
+
+  this->journal_patch = GraphPatch();
 }
 
 void GraphViewer::save_screenshot(const std::string &fname)
@@ -1009,18 +2301,187 @@ void GraphViewer::save_screenshot(const std::string &fname)
   pixMap.save(fname.c_str());
 }
 
+void GraphViewer::schedule_materialization()
+{
+  if (!this->node_placeholders.empty() && !this->materialization_timer->isActive())
+    this->materialization_timer->start();
+}
+
 void GraphViewer::select_all()
 {
-  for (QGraphicsItem *item : this->scene()->items())
-    if (!is_item_static(item))
-      item->setSelected(true);
+  for (GraphicsNode *p_node : this->nodes)
+    p_node->setSelected(true);
+
+  for (GraphicsLink *p_link : this->links)
+    p_link->setSelected(true);
+
+  for (GraphicsGroup *p_group : this->groups)
+    p_group->setSelected(true);
+}
+
+std::string GraphViewer::selection_to_binary() const
+{
+  GraphRecord record;
+  record.id = this->id;
+  record.current_link_type = (int)this->current_link_type;
+
+  QRectF bbox;
+
+  for (GraphicsNode *p_node : this->nodes)
+    if (p_node->isSelected())
+    {
+      record.nodes.push_back(p_node->record_to());
+      bbox = bbox.united(p_node->sceneBoundingRect());
+
+      // internal links, taken from their output node so that each one
+      // is only visited once
+      for (GraphicsLink *p_link : p_node->get_connected_links())
+        if (p_link->get_node_out() == p_node && p_link->get_node_in() &&
+            p_link->get_node_in()->isSelected())
+          record.links.push_back(p_link->record_to());
+    }
+
+  // selected groups and the groups enclosing only selected nodes
+  for (GraphicsGroup *p_group : this->groups)
+    if (p_group->isSelected() || (!bbox.isEmpty() &&
+                                  bbox.contains(p_group->sceneBoundingRect())))
+      record.groups.push_back(p_group->record_to());
+
+  return graph_record_to_binary(record);
+}
+
+void GraphViewer::set_lazy_node_materialization(bool new_state)
+{
+  this->is_lazy_materialization = new_state;
+
+  if (!new_state)
+    this->materialize_all_nodes();
+}
+
+void GraphViewer::start_autosave(const std::string &fname,
+                                 int                interval_ms,
+                                 bool               compress)
+{
+  this->autosave_fname = fname;
+  this->is_autosave_compressed = compress;
+
+  if (!this->autosave_worker)
+    this->autosave_worker = std::make_unique<AutosaveWorker>();
+
+  if (!this->autosave_timer)
+  {
+    this->autosave_timer = new QTimer(this);
+    this->connect(this->autosave_timer, &QTimer::timeout, [this]() { this->autosave(); });
+  }
+
+  this->autosave_timer->start(interval_ms);
+}
+
+void GraphViewer::stop_autosave()
+{
+  if (this->autosave_timer)
+    this->autosave_timer->stop();
+
+  // waits for the save in progress
+  this->autosave_worker.reset();
+}
+
+std::string_view GraphViewer::store_placeholder_string(std::string &&string)
+{
+  // a deque never moves its elements, the views stay valid
+  this->placeholder_strings.push_back(std::move(string));
+  return this->placeholder_strings.back();
 }
 
 void GraphViewer::toggle_link_type()
 {
-  for (QGraphicsItem *item : this->scene()->items())
-    if (GraphicsLink *p_link = dynamic_cast<GraphicsLink *>(item))
-      this->current_link_type = p_link->toggle_link_type();
+  for (GraphicsLink *p_link : this->links)
+    this->current_link_type = p_link->toggle_link_type();
+}
+
+void GraphViewer::tune_scene_index()
+{
+  if (this->scene()->itemIndexMethod() != QGraphicsScene::BspTreeIndex)
+    return;
+
+  int depth = GN_STYLE->viewer.bsp_tree_depth;
+
+  if (depth <= 0)
+  {
+    // about 16 items per leaf, Qt automatic depth is much deeper for
+    // large graphs (log2 of the item count) and leaves many leaves empty
+    size_t nitems = this->nodes.size() + this->links.size() + this->groups.size();
+    depth = std::clamp((int)std::ceil(std::log2((double)nitems / 16.0 + 1.0)), 4, 16);
+  }
+
+  // changing the depth rebuilds the index
+  if (this->scene()->bspTreeDepth() != depth)
+    this->scene()->setBspTreeDepth(depth);
+}
+
+void GraphViewer::unregister_item(QGraphicsItem *item)
+{
+  if (GraphicsNode *p_node = dynamic_cast<GraphicsNode *>(item))
+  {
+    this->journal_node_removed(p_node);
+    this->pending_links_by_node.erase(p_node->get_id());
+    erase_from_registry(this->nodes, this->node_slots, p_node);
+
+    auto it = this->nodes_by_id.find(p_node->get_id());
+    if (it != this->nodes_by_id.end() && it->second == p_node)
+      this->nodes_by_id.erase(it);
+  }
+  else if (GraphicsLink *p_link = dynamic_cast<GraphicsLink *>(item))
+    this->unregister_link(p_link);
+  else if (GraphicsGroup *p_group = dynamic_cast<GraphicsGroup *>(item))
+  {
+    std::erase(this->groups, p_group);
+    this->are_groups_dirty = true;
+  }
+}
+
+void GraphViewer::unregister_link(GraphicsLink *p_link)
+{
+  if (!p_link->get_node_out() || !p_link->get_node_in())
+    return;
+
+  this->journal_link_removed(p_link);
+  p_link->set_is_batched(false);
+  erase_from_registry(this->links, this->link_slots, p_link);
+  p_link->get_node_out()->remove_connected_link(p_link);
+  p_link->get_node_in()->remove_connected_link(p_link);
+}
+
+void GraphViewer::update_connection_target(QPointF scene_pos)
+{
+  // only the node under the cursor is hit-tested (using the scene
+  // index), the cost per mouse move does not depend on the graph size
+  GraphicsNode *p_target = nullptr;
+
+  for (QGraphicsItem *item : this->scene()->items(scene_pos))
+    if (GraphicsNode *p_node = dynamic_cast<GraphicsNode *>(item))
+    {
+      p_target = p_node;
+      break;
+    }
+
+  // the link cannot loop back on its source node
+  if (p_target == this->source_node)
+    p_target = nullptr;
+
+  // leaving the previous target
+  if (this->target_node && this->target_node != p_target)
+  {
+    this->target_node->reset_is_port_hovered();
+    this->target_node->update_render_state();
+  }
+
+  this->target_node = p_target;
+
+  if (this->target_node)
+    this->target_node->update_connection_hover(scene_pos,
+                                               this->source_node,
+                                               this->source_port_index);
 }
 
 void GraphViewer::wheelEvent(QWheelEvent *event)
@@ -1038,30 +2499,19 @@ void GraphViewer::wheelEvent(QWheelEvent *event)
   QPointF delta = new_mouse_scene_pos - mouse_scene_pos;
   this->translate(delta.x(), delta.y());
 
+  this->schedule_materialization();
+
   event->accept();
 }
 
 void GraphViewer::zoom_to_content()
 {
-  QRectF bbox;
+  // the scene only holds the graph items (the toolbar is an overlay)
+  QRectF bbox = this->get_items_bounding_rect();
 
-  // if there are no static items, the built-in scene bounding
-  // rectangle is used. If not, the bounding box is recomputed with the
-  // static items excluded
-  if (this->static_items.empty())
-    bbox = this->scene()->itemsBoundingRect();
-  else
-  {
-    std::vector<QGraphicsItem *> items_not_static;
-
-    for (QGraphicsItem *item : this->scene()->items())
-    {
-      if (!this->is_item_static(item))
-        items_not_static.push_back(item);
-
-      bbox = compute_bounding_rect(items_not_static);
-    }
-  }
+  // nodes not materialized yet
+  for (auto &[_, node] : this->node_placeholders)
+    bbox = bbox.united(this->get_placeholder_rect(node));
 
   // add a margin
   float margin_x = 0.1f * bbox.width();
@@ -1069,6 +2519,7 @@ void GraphViewer::zoom_to_content()
   bbox.adjust(-margin_x, -margin_y, margin_x, margin_y);
 
   this->fitInView(bbox, Qt::KeepAspectRatio);
+  this->schedule_materialization();
 }
 
 } // namespace gngui
@@ -1,6 +1,8 @@
 /* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
+#include <unordered_set>
+
 #include <QAction>
 #include <QGraphicsProxyWidget>
 #include <QGraphicsScene>
@@ -31,10 +33,12 @@ QPixmap create_colored_pixmap(const QColor &color, QSize size = QSize(64, 16))
 }
 
 GraphicsGroup::GraphicsGroup(QGraphicsItem *parent)
-    : QGraphicsRectItem(parent), resizing(false), resize_handle_size(20.f)
+    : QGraphicsRectItem(parent), resizing(false), resize_handle_size(20.f),
+      dragging(false)
 {
   this->setFlag(QGraphicsItem::ItemIsSelectable, true);
   this->setFlag(QGraphicsItem::ItemIsMovable, true);
+  this->setFlag(QGraphicsItem::ItemSendsGeometryChanges, true);
   this->setAcceptHoverEvents(true);
   this->setRect(0.f, 0.f, 256.f, 128.f);
   this->setZValue(-2);
@@ -156,33 +160,22 @@ void GraphicsGroup::hoverMoveEvent(QGraphicsSceneHoverEvent *event)
   QGraphicsRectItem::hoverMoveEvent(event);
 }
 
-void GraphicsGroup::json_from(nlohmann::json json)
+QVariant GraphicsGroup::itemChange(GraphicsItemChange change, const QVariant &value)
 {
-  std::vector<float> pos = json["position"];
-  float              width = json["width"];
-  float              height = json["height"];
-  this->setRect(QRectF(pos[0], pos[1], width, height));
+  if (change == QGraphicsItem::ItemPositionHasChanged)
+    this->is_dirty = true;
 
-  this->set_caption(json["caption"]);
+  return QGraphicsRectItem::itemChange(change, value);
+}
 
-  std::vector<float> cvec = json["color"];
-  this->set_color(QColor(cvec[0], cvec[1], cvec[2], cvec[3]));
+void GraphicsGroup::json_from(nlohmann::json json)
+{
+  this->record_from(group_record_from_json(json));
 }
 
 nlohmann::json GraphicsGroup::json_to() const
 {
-  nlohmann::json json;
-
-  json["caption"] = this->caption_item->document()->toRawText().toStdString();
-  json["position"] = {this->scenePos().x(), this->scenePos().y()};
-  json["width"] = this->rect().width();
-  json["height"] = this->rect().height();
-  json["color"] = {this->color.red(),
-                   this->color.green(),
-                   this->color.blue(),
-                   this->color.alpha()};
-
-  return json;
+  return group_record_to_json(this->record_to());
 }
 
 void GraphicsGroup::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event)
@@ -207,6 +200,7 @@ void GraphicsGroup::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event)
     {
       this->caption_item->setPlainText(new_caption);
       this->update_caption_position();
+      this->is_dirty = true;
     }
   }
   QGraphicsRectItem::mouseDoubleClickEvent(event);
@@ -235,6 +229,22 @@ void GraphicsGroup::mousePressEvent(QGraphicsSceneMouseEvent *event)
       QRectF bbox = this->rect();
       bbox.moveTo(this->scenePos());
       this->selected_items = this->scene()->items(bbox);
+
+      // the nodes do not update their links while moving, each link
+      // is updated once per move event, even if both its end nodes
+      // are moved
+      std::unordered_set<GraphicsLink *> links_set = {};
+      this->dragged_links.clear();
+
+      for (QGraphicsItem *item : this->selected_items)
+        if (GraphicsNode *p_node = dynamic_cast<GraphicsNode *>(item))
+        {
+          p_node->set_connected_links_update(false);
+
+          for (GraphicsLink *p_link : p_node->get_connected_links())
+            if (links_set.insert(p_link).second)
+              this->dragged_links.push_back(p_link);
+        }
     }
   }
 
@@ -269,6 +279,7 @@ void GraphicsGroup::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
 
     this->setRect(new_rect);
     this->resize_start_pos = event->pos();
+    this->is_dirty = true;
 
     this->update_caption_position();
     return;
@@ -293,6 +304,9 @@ void GraphicsGroup::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
             p_group->moveBy(delta.x(), delta.y());
       }
 
+    for (GraphicsLink *p_link : this->dragged_links)
+      p_link->update_path();
+
     // move the rectangle itself
     this->setPos(pos() + delta);
     this->drag_start_pos = event->scenePos();
@@ -305,6 +319,12 @@ void GraphicsGroup::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
 
 void GraphicsGroup::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
 {
+  if (this->dragging)
+    for (QGraphicsItem *item : this->selected_items)
+      if (GraphicsNode *p_node = dynamic_cast<GraphicsNode *>(item))
+        p_node->set_connected_links_update(true);
+
+  this->dragged_links.clear();
   this->resizing = false;
   this->dragging = false;
   QGraphicsRectItem::mouseReleaseEvent(event);
@@ -340,16 +360,48 @@ void GraphicsGroup::paint(QPainter                       *painter,
                            GN_STYLE->group.rounding_radius);
 }
 
+void GraphicsGroup::record_from(const GroupRecord &record)
+{
+  // the record position is the scene position of the top-left corner
+  this->setPos(QPointF(record.x, record.y));
+  this->setRect(QRectF(0.f, 0.f, record.width, record.height));
+
+  this->set_caption(record.caption);
+  this->set_color(
+      QColor(record.color[0], record.color[1], record.color[2], record.color[3]));
+}
+
+GroupRecord GraphicsGroup::record_to() const
+{
+  GroupRecord record;
+
+  QPointF top_left = this->mapToScene(this->rect().topLeft());
+
+  record.caption = this->caption_item->document()->toRawText().toStdString();
+  record.x = top_left.x();
+  record.y = top_left.y();
+  record.width = this->rect().width();
+  record.height = this->rect().height();
+  record.color = {this->color.red(),
+                  this->color.green(),
+                  this->color.blue(),
+                  this->color.alpha()};
+
+  return record;
+}
+
 void GraphicsGroup::set_caption(const std::string &new_caption)
 {
   this->caption_item->setPlainText(new_caption.c_str());
   this->update_caption_position();
+  this->is_dirty = true;
 }
 
 void GraphicsGroup::set_color(const QColor &new_color)
 {
   this->color = new_color;
   this->caption_item->setDefaultTextColor(this->color);
+  this->is_dirty = true;
   this->update();
 }
 
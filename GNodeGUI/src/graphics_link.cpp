@@ -4,10 +4,16 @@
 #include <QPainter>
 #include <QPainterPath>
 #include <QPen>
+#include <QStyleOptionGraphicsItem>
 
 #include "gnodegui/graphics_link.hpp"
 #include "gnodegui/logger.hpp"
 #include "gnodegui/style.hpp"
+#include "gnodegui/update_scheduler.hpp"
+#include "gnodegui/utils.hpp"
+
+// number of segments used to flatten the Bezier curves for hit-testing
+#define HIT_CUBIC_SEGMENTS 16
 
 namespace gngui
 {
@@ -26,6 +32,11 @@ GraphicsLink::GraphicsLink(QColor color, LinkType link_type, QGraphicsItem *pare
   this->setZValue(-1);
 }
 
+GraphicsLink::~GraphicsLink()
+{
+  cancel_item_update(this);
+}
+
 QRectF GraphicsLink::boundingRect() const
 {
   QRectF bbox = this->path().boundingRect();
@@ -36,10 +47,27 @@ QRectF GraphicsLink::boundingRect() const
   return bbox;
 }
 
+bool GraphicsLink::contains(const QPointF &point) const
+{
+  float d = GN_STYLE->link.hit_distance;
+
+  // quick rejection using the bounding box of the path
+  if (!this->path().boundingRect().adjusted(-d, -d, d, d).contains(point))
+    return false;
+
+  for (size_t k = 1; k < this->hit_polyline.size(); k++)
+    if (distance_to_segment_squared(point,
+                                    this->hit_polyline[k - 1],
+                                    this->hit_polyline[k]) <= d * d)
+      return true;
+
+  return false;
+}
+
 void GraphicsLink::hoverEnterEvent(QGraphicsSceneHoverEvent *event)
 {
   this->is_link_hovered = true;
-  this->update();
+  schedule_item_update(this, this->boundingRect());
 
   QGraphicsPathItem::hoverEnterEvent(event);
 }
@@ -47,34 +75,42 @@ void GraphicsLink::hoverEnterEvent(QGraphicsSceneHoverEvent *event)
 void GraphicsLink::hoverLeaveEvent(QGraphicsSceneHoverEvent *event)
 {
   this->is_link_hovered = false;
-  this->update();
+  schedule_item_update(this, this->boundingRect());
 
   QGraphicsPathItem::hoverLeaveEvent(event);
 }
 
 nlohmann::json GraphicsLink::json_to() const
 {
-  nlohmann::json json;
-
-  json["node_out_id"] = this->node_out->get_id();
-  json["node_in_id"] = this->node_in->get_id();
-
-  json["port_out_id"] = this->node_out->get_port_id(this->port_out_index);
-  json["port_in_id"] = this->node_in->get_port_id(this->port_in_index);
-
-  json["link_type"] = this->link_type;
-
-  return json;
+  return link_record_to_json(this->record_to());
 }
 
 void GraphicsLink::paint(QPainter                       *painter,
                          const QStyleOptionGraphicsItem *option,
                          QWidget                        *widget)
 {
-  Q_UNUSED(option);
   Q_UNUSED(widget);
 
+  // drawn along with the other links by the viewer
+  if (this->path().elementCount() == 0 || this->is_batch_painted())
+    return;
+
+  GraphicsLink::paint_count++;
+
   QColor pcolor = this->isSelected() ? GN_STYLE->link.color_selected : this->color;
+
+  // zoomed out, straight single-pixel line (cosmetic pen)
+  const qreal lod = option->levelOfDetailFromTransform(painter->worldTransform());
+
+  if (lod < GN_STYLE->link.lod_simplified)
+  {
+    painter->setPen(QPen(pcolor, 0.f));
+    painter->setBrush(Qt::NoBrush);
+    painter->drawLine(this->path().elementAt(0),
+                      this->path().elementAt(this->path().elementCount() - 1));
+    return;
+  }
+
   float  pwidth = this->is_link_hovered
                       ? GN_STYLE->link.pen_width_hovered
                       : (this->isSelected() ? GN_STYLE->link.pen_width_selected
@@ -87,20 +123,7 @@ void GraphicsLink::paint(QPainter                       *painter,
   painter->setPen(pen);
   painter->setBrush(Qt::NoBrush);
 
-  // update path
-  if (this->node_out && this->node_in)
-  {
-    QPointF start_point = this->node_out->scenePos() + this->node_out->get_geometry_ref()
-                                                           ->port_rects[port_out_index]
-                                                           .center();
-    QPointF end_point = this->node_in->scenePos() + this->node_in->get_geometry_ref()
-                                                        ->port_rects[port_in_index]
-                                                        .center();
-
-    this->set_endpoints(start_point, end_point);
-  }
-
-  // draw path
+  // draw path (cached, only recomputed when the end nodes move)
   painter->drawPath(this->path());
 
   // port tips
@@ -119,6 +142,19 @@ void GraphicsLink::paint(QPainter                       *painter,
   }
 }
 
+LinkRecord GraphicsLink::record_to() const
+{
+  LinkRecord record;
+
+  record.node_out_id = this->node_out->get_id();
+  record.node_in_id = this->node_in->get_id();
+  record.port_out_id = this->node_out->get_port_id(this->port_out_index);
+  record.port_in_id = this->node_in->get_port_id(this->port_in_index);
+  record.link_type = this->link_type;
+
+  return record;
+}
+
 void GraphicsLink::set_endnodes(GraphicsNode *from,
                                 int           port_from_index,
                                 GraphicsNode *to,
@@ -131,7 +167,7 @@ void GraphicsLink::set_endnodes(GraphicsNode *from,
   }
 
   // put the ports in the right order (from output to input)
-  if (from->get_proxy_ref()->get_port_type(port_from_index) == PortType::OUT)
+  if (from->get_port_type(port_from_index) == PortType::OUT)
   {
     // 'from' is the output node, 'to' is the input node
     this->node_out = from;
@@ -147,18 +183,42 @@ void GraphicsLink::set_endnodes(GraphicsNode *from,
     this->node_out = to;
     this->port_out_index = port_to_index;
   }
+
+  this->update_path();
 }
 
 void GraphicsLink::set_endpoints(const QPointF &start_point, const QPointF &end_point)
 {
   QPainterPath new_path(start_point);
 
+  // the hit-testing polyline is built along with the path: polyline
+  // vertices for the straight segments and flattened Bezier curves
+  this->hit_polyline = {start_point};
+
+  auto flatten_cubic = [this](const QPointF &p0,
+                              const QPointF &p1,
+                              const QPointF &p2,
+                              const QPointF &p3)
+  {
+    for (int k = 1; k <= HIT_CUBIC_SEGMENTS; k++)
+    {
+      float t = (float)k / (float)HIT_CUBIC_SEGMENTS;
+      float s = 1.f - t;
+      this->hit_polyline.push_back(s * s * s * p0 + 3.f * s * s * t * p1 +
+                                   3.f * s * t * t * p2 + t * t * t * p3);
+    }
+  };
+
   if (this->link_type == LinkType::BROKEN_LINE)
   {
     float dx = std::copysign(20.f, end_point.x() - start_point.x());
     new_path.lineTo(QPointF(start_point.x() + dx, start_point.y()));
     new_path.lineTo(QPointF(end_point.x() - dx, end_point.y()));
     new_path.lineTo(end_point);
+
+    this->hit_polyline.push_back(QPointF(start_point.x() + dx, start_point.y()));
+    this->hit_polyline.push_back(QPointF(end_point.x() - dx, end_point.y()));
+    this->hit_polyline.push_back(end_point);
   }
   else if (this->link_type == LinkType::CIRCUIT)
   {
@@ -166,6 +226,10 @@ void GraphicsLink::set_endpoints(const QPointF &start_point, const QPointF &end_
     new_path.lineTo(QPointF(mid_point.x(), start_point.y()));
     new_path.lineTo(QPointF(mid_point.x(), end_point.y()));
     new_path.lineTo(end_point);
+
+    this->hit_polyline.push_back(QPointF(mid_point.x(), start_point.y()));
+    this->hit_polyline.push_back(QPointF(mid_point.x(), end_point.y()));
+    this->hit_polyline.push_back(end_point);
   }
   else if (this->link_type == LinkType::CUBIC)
   {
@@ -173,6 +237,8 @@ void GraphicsLink::set_endpoints(const QPointF &start_point, const QPointF &end_
     QPointF control_point1(start_point.x() + dx, start_point.y());
     QPointF control_point2(end_point.x() - dx, end_point.y());
     new_path.cubicTo(control_point1, control_point2, end_point);
+
+    flatten_cubic(start_point, control_point1, control_point2, end_point);
   }
   else if (this->link_type == LinkType::DEPORTED)
   {
@@ -184,27 +250,69 @@ void GraphicsLink::set_endpoints(const QPointF &start_point, const QPointF &end_
     QPointF control_point1(mid_point.x() + dx, mid_point.y());
     QPointF control_point2(end_point.x() - dx, end_point.y());
     new_path.cubicTo(control_point1, control_point2, end_point);
+
+    this->hit_polyline.push_back(mid_point);
+    flatten_cubic(mid_point, control_point1, control_point2, end_point);
   }
   else if (this->link_type == LinkType::LINEAR)
   {
     new_path.lineTo(end_point);
+
+    this->hit_polyline.push_back(end_point);
   }
 
   this->setPath(new_path);
+  this->is_shape_cache_dirty = true;
+}
+
+void GraphicsLink::set_is_batched(bool new_state)
+{
+  if (this->is_batched == new_state)
+    return;
+
+  this->is_batched = new_state;
+  this->update();
 }
 
 void GraphicsLink::set_link_type(const LinkType &new_link_type)
 {
   this->link_type = new_link_type;
-  this->update();
+
+  if (this->node_out && this->node_in)
+    this->update_path();
+  else if (this->path().elementCount() > 0)
+    this->set_endpoints(this->path().pointAtPercent(0), this->path().pointAtPercent(1));
 }
 
 QPainterPath GraphicsLink::shape() const
 {
-  QPainterPathStroker stroker;
-  stroker.setWidth(40);
-  QPainterPath widened_path = stroker.createStroke(path());
-  return widened_path.united(path());
+  // still needed for shape-based queries (rubber band selection for
+  // instance), only rebuilt when the path changes
+  if (this->is_shape_cache_dirty)
+  {
+    QPainterPathStroker stroker;
+    stroker.setWidth(2.f * GN_STYLE->link.hit_distance);
+    QPainterPath widened_path = stroker.createStroke(path());
+    this->shape_cache = widened_path.united(path());
+    this->is_shape_cache_dirty = false;
+  }
+
+  return this->shape_cache;
+}
+
+void GraphicsLink::update_path()
+{
+  if (!this->node_out || !this->node_in)
+    return;
+
+  QPointF start_point = this->node_out->scenePos() + this->node_out->get_geometry_ref()
+                                                         ->port_rects[port_out_index]
+                                                         .center();
+  QPointF end_point = this->node_in->scenePos() + this->node_in->get_geometry_ref()
+                                                      ->port_rects[port_in_index]
+                                                      .center();
+
+  this->set_endpoints(start_point, end_point);
 }
 
 LinkType GraphicsLink::toggle_link_type()
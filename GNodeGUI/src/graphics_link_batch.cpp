@@ -0,0 +1,119 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <map>
+#include <vector>
+
+#include <QGraphicsScene>
+#include <QPainter>
+#include <QPen>
+#include <QStyleOptionGraphicsItem>
+
+#include "gnodegui/graphics_link.hpp"
+#include "gnodegui/graphics_link_batch.hpp"
+#include "gnodegui/style.hpp"
+
+namespace gngui
+{
+
+GraphicsLinkBatch::GraphicsLinkBatch(QGraphicsItem *parent) : QGraphicsItem(parent)
+{
+  // same layer as the links (see GraphicsLink)
+  this->setZValue(-1);
+  this->setAcceptedMouseButtons(Qt::NoButton);
+  this->setAcceptHoverEvents(false);
+  this->setFlag(QGraphicsItem::ItemUsesExtendedStyleOption, true);
+}
+
+void GraphicsLinkBatch::paint(QPainter                       *painter,
+                              const QStyleOptionGraphicsItem *option,
+                              QWidget                        *widget)
+{
+  Q_UNUSED(widget);
+
+  if (!GN_STYLE->link.batched_rendering || !this->scene())
+    return;
+
+  struct LinkBatch
+  {
+    QPainterPath        path;
+    QPainterPath        tips;
+    std::vector<QLineF> lines;
+  };
+
+  const qreal lod = option->levelOfDetailFromTransform(painter->worldTransform());
+  const bool  is_simplified = lod < GN_STYLE->link.lod_simplified;
+  const float radius = GN_STYLE->link.port_tip_radius;
+
+  std::map<std::pair<QRgb, int>, LinkBatch> batches;
+
+  // the item sits at the scene origin, the exposed rect is in scene
+  // coordinates
+  for (QGraphicsItem *item : this->scene()->items(option->exposedRect,
+                                                  Qt::IntersectsItemBoundingRect,
+                                                  Qt::AscendingOrder))
+  {
+    GraphicsLink *p_link = dynamic_cast<GraphicsLink *>(item);
+
+    if (!p_link || !p_link->is_batch_painted() || !p_link->isVisible())
+      continue;
+
+    const QPainterPath &path = p_link->path();
+    int                 n = path.elementCount();
+
+    if (n == 0)
+      continue;
+
+    QRgb       color = p_link->get_color().rgba();
+    LinkBatch &batch = batches[{color, (int)p_link->get_pen_style()}];
+    QPointF    start_point = p_link->pos() + QPointF(path.elementAt(0));
+    QPointF    end_point = p_link->pos() + QPointF(path.elementAt(n - 1));
+
+    if (is_simplified)
+      batch.lines.push_back(QLineF(start_point, end_point));
+    else
+    {
+      // overlapping tips must not cancel each other out
+      batch.tips.setFillRule(Qt::WindingFill);
+      batch.path.addPath(path.translated(p_link->pos()));
+      batch.tips.addEllipse(start_point, radius, radius);
+      batch.tips.addEllipse(end_point, radius, radius);
+    }
+
+    this->paint_count++;
+  }
+
+  for (auto &[key, batch] : batches)
+  {
+    QColor color = QColor::fromRgba(key.first);
+
+    if (is_simplified)
+    {
+      painter->setPen(QPen(color, 0.f));
+      painter->drawLines(batch.lines.data(), (int)batch.lines.size());
+      continue;
+    }
+
+    QPen pen(color);
+    pen.setWidth(GN_STYLE->link.pen_width);
+    pen.setStyle((Qt::PenStyle)key.second);
+
+    painter->setPen(pen);
+    painter->setBrush(Qt::NoBrush);
+    painter->drawPath(batch.path);
+
+    painter->setBrush(color);
+    painter->drawPath(batch.tips);
+  }
+}
+
+void GraphicsLinkBatch::set_bounding_rect(const QRectF &new_bbox)
+{
+  if (new_bbox == this->bbox)
+    return;
+
+  this->prepareGeometryChange();
+  this->bbox = new_bbox;
+}
+
+} // namespace gngui
@@ -9,6 +9,7 @@
 #include <QGraphicsScene>
 #include <QGraphicsSceneMouseEvent>
 #include <QPainter>
+#include <QStyleOptionGraphicsItem>
 
 #include "gnodegui/graphics_link.hpp"
 #include "gnodegui/graphics_node.hpp"
@@ -16,6 +17,7 @@
 #include "gnodegui/icons/show_settings_icon.hpp"
 #include "gnodegui/logger.hpp"
 #include "gnodegui/style.hpp"
+#include "gnodegui/update_scheduler.hpp"
 #include "gnodegui/utils.hpp"
 
 namespace gngui
@@ -29,12 +31,22 @@ GraphicsNode::GraphicsNode(NodeProxy *p_node_proxy, QGraphicsItem *parent)
   this->setFlag(QGraphicsItem::ItemDoesntPropagateOpacityToChildren, false);
   this->setFlag(QGraphicsItem::ItemIsFocusable, true);
   this->setFlag(QGraphicsItem::ItemClipsChildrenToShape, false);
+  this->setFlag(QGraphicsItem::ItemSendsGeometryChanges, true);
   this->setAcceptHoverEvents(true);
   this->setOpacity(1.f);
   this->setZValue(0);
 
-  this->is_port_hovered.resize(this->get_nports());
-  this->connected_link_ref.resize(this->get_nports());
+  // the node is rendered once in a pixmap, re-rendered only when its
+  // visual state changes (see update_render_state) or when the zoom
+  // level changes, panning the view is then only blits. Not used with
+  // the render stats, which count the paint calls
+  if (GN_STYLE->node.render_cache && !GN_STYLE->viewer.show_render_stats)
+    this->setCacheMode(QGraphicsItem::DeviceCoordinateCache);
+
+  // resolve the strings used in the hot paths (painting, connection
+  // checks) once for all
+  this->category_id = intern_category(this->get_main_category());
+  this->load_ports();
 
   this->update_geometry();
 
@@ -70,6 +82,7 @@ GraphicsNode::GraphicsNode(NodeProxy *p_node_proxy, QGraphicsItem *parent)
                   [this]()
                   {
                     this->is_widget_visible = !this->is_widget_visible;
+                    this->is_dirty = true;
                     this->set_qwidget_visibility(this->is_widget_visible);
                   });
   }
@@ -91,6 +104,16 @@ GraphicsNode::GraphicsNode(NodeProxy *p_node_proxy, QGraphicsItem *parent)
   }
 }
 
+GraphicsNode::~GraphicsNode()
+{
+  cancel_item_update(this);
+}
+
+void GraphicsNode::add_connected_link(GraphicsLink *p_link)
+{
+  this->connected_links.push_back(p_link);
+}
+
 std::vector<std::string> GraphicsNode::get_category_splitted(char delimiter) const
 {
   return split_string(this->get_category(), delimiter);
@@ -119,17 +142,14 @@ std::string GraphicsNode::get_main_category() const
 
 int GraphicsNode::get_port_index(const std::string &id) const
 {
-  for (int k = 0; k < this->get_nports(); k++)
-    if (this->get_port_id(k) == id)
-      return k;
-
-  return -1;
+  auto it = this->port_index_by_id.find(id);
+  return it == this->port_index_by_id.end() ? -1 : it->second;
 }
 
 void GraphicsNode::hoverEnterEvent(QGraphicsSceneHoverEvent *event)
 {
   this->is_node_hovered = true;
-  this->update();
+  this->update_render_state();
 
   QGraphicsRectItem::hoverEnterEvent(event);
 }
@@ -137,7 +157,7 @@ void GraphicsNode::hoverEnterEvent(QGraphicsSceneHoverEvent *event)
 void GraphicsNode::hoverLeaveEvent(QGraphicsSceneHoverEvent *event)
 {
   this->is_node_hovered = false;
-  this->update();
+  this->update_render_state();
 
   QGraphicsRectItem::hoverLeaveEvent(event);
 }
@@ -149,7 +169,7 @@ void GraphicsNode::hoverMoveEvent(QGraphicsSceneHoverEvent *event)
   QPointF item_pos = scene_pos - this->scenePos();
 
   if (this->update_is_port_hovered(item_pos))
-    this->update();
+    this->update_render_state();
 
   QGraphicsRectItem::hoverMoveEvent(event);
 }
@@ -158,8 +178,13 @@ bool GraphicsNode::is_port_available(int port_index)
 {
   if (this->get_port_type(port_index) == PortType::OUT)
     return true;
-  else
-    return !this->connected_link_ref[port_index];
+
+  // an input port accepts only one link
+  for (GraphicsLink *p_link : this->connected_links)
+    if (p_link->get_node_in() == this && p_link->get_port_in_index() == port_index)
+      return false;
+
+  return true;
 }
 
 QVariant GraphicsNode::itemChange(GraphicsItemChange change, const QVariant &value)
@@ -171,32 +196,30 @@ QVariant GraphicsNode::itemChange(GraphicsItemChange change, const QVariant &val
     else
       Q_EMIT this->selected(this->get_id());
   }
+  else if (change == QGraphicsItem::ItemSelectedHasChanged)
+  {
+    // repaint already requested by Qt, only keep the state in sync
+    this->render_state.is_selected = this->isSelected();
+  }
+  else if (change == QGraphicsItem::ItemPositionHasChanged)
+  {
+    this->is_dirty = true;
+
+    if (this->is_connected_links_update_enabled)
+      this->update_connected_links();
+  }
 
   return QGraphicsItem::itemChange(change, value);
 }
 
 void GraphicsNode::json_from(nlohmann::json json)
 {
-  this->get_id() = json["id"];
-  this->get_caption() = json["caption"];
-  this->is_widget_visible = json["is_widget_visible"];
-
-  float x = json["scene_position.x"];
-  float y = json["scene_position.y"];
-  this->setPos(QPointF(x, y));
+  this->record_from(node_record_from_json(json));
 }
 
 nlohmann::json GraphicsNode::json_to() const
 {
-  nlohmann::json json;
-
-  json["id"] = this->get_id();
-  json["caption"] = this->get_caption();
-  json["is_widget_visible"] = this->is_widget_visible;
-  json["scene_position.x"] = this->scenePos().x();
-  json["scene_position.y"] = this->scenePos().y();
-
-  return json;
+  return node_record_to_json(this->record_to());
 }
 
 void GraphicsNode::mousePressEvent(QGraphicsSceneMouseEvent *event)
@@ -214,7 +237,6 @@ void GraphicsNode::mousePressEvent(QGraphicsSceneMouseEvent *event)
       this->has_connection_started = true;
       this->setFlag(QGraphicsItem::ItemIsMovable, false);
       this->port_index_from = hovered_port_index;
-      this->data_type_connecting = this->get_data_type(hovered_port_index);
       Q_EMIT connection_started(this, hovered_port_index);
       event->accept();
     }
@@ -274,7 +296,7 @@ void GraphicsNode::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
         }
 
       this->reset_is_port_hovered();
-      this->update();
+      this->update_render_state();
 
       if (is_dropped)
       {
@@ -284,15 +306,6 @@ void GraphicsNode::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
       }
 
       this->has_connection_started = false;
-
-      // clean-up port color state
-      for (QGraphicsItem *item : this->scene()->items())
-        if (GraphicsNode *node = dynamic_cast<GraphicsNode *>(item))
-        {
-          node->data_type_connecting = "";
-          node->update();
-        }
-
       this->setFlag(QGraphicsItem::ItemIsMovable, true);
     }
   }
@@ -303,23 +316,43 @@ void GraphicsNode::on_compute_finished()
 {
   Logger::log()->trace("GraphicsNode::on_compute_finished, node {}", this->get_caption());
   this->is_node_computing = false;
-  this->update();
+  this->update_render_state();
 }
 
 void GraphicsNode::on_compute_started()
 {
   Logger::log()->trace("GraphicsNode::on_compute_started, node {}", this->get_caption());
   this->is_node_computing = true;
-  this->update();
+  this->update_render_state();
 }
 
 void GraphicsNode::paint(QPainter                       *painter,
                          const QStyleOptionGraphicsItem *option,
                          QWidget                        *widget)
 {
-  Q_UNUSED(option);
   Q_UNUSED(widget);
 
+  GraphicsNode::paint_count++;
+
+  const qreal lod = option->levelOfDetailFromTransform(painter->worldTransform());
+
+  QColor header_color = get_color_from_category_id(this->category_id);
+
+  // --- Simplified rendering when zoomed out (flat colored rectangle)
+
+  if (lod < GN_STYLE->node.lod_simplified)
+  {
+    if (this->isSelected())
+      painter->setPen(
+          QPen(GN_STYLE->node.color_selected, GN_STYLE->node.pen_width_selected));
+    else
+      painter->setPen(Qt::NoPen);
+
+    painter->setBrush(header_color);
+    painter->drawRect(this->geometry.body_rect);
+    return;
+  }
+
   // --- Background rectangle
 
   painter->setBrush(QBrush(GN_STYLE->node.color_bg));
@@ -330,18 +363,16 @@ void GraphicsNode::paint(QPainter                       *painter,
 
   // --- Caption
 
-  // Set pen based on whether the node is selected or not
-  painter->setPen(this->isSelected() ? GN_STYLE->node.color_selected
-                                     : GN_STYLE->node.color_caption);
-  painter->drawText(this->geometry.caption_pos, this->get_caption().c_str());
+  if (lod >= GN_STYLE->node.lod_caption)
+  {
+    // Set pen based on whether the node is selected or not
+    painter->setPen(this->isSelected() ? GN_STYLE->node.color_selected
+                                       : GN_STYLE->node.color_caption);
+    painter->drawText(this->geometry.caption_pos, this->caption_label);
+  }
 
   // --- Header
 
-  std::string main_category = this->get_main_category();
-  QColor      header_color = GN_STYLE->node.color_bg_light;
-
-  if (GN_STYLE->node.color_category.contains(main_category))
-    header_color = GN_STYLE->node.color_category.at(main_category);
   painter->setBrush(header_color);
 
   if (this->is_node_computing)
@@ -385,17 +416,22 @@ void GraphicsNode::paint(QPainter                       *painter,
 
   // --- Ports
 
-  for (int k = 0; k < this->p_node_proxy->get_nports(); k++)
+  // bounded by the port table, the proxy may have changed its ports
+  // since the last refresh_ports
+  for (int k = 0; k < this->get_nports(); k++)
   {
     // Set alignment based on port type (IN/OUT)
     int align_flag = (this->get_port_type(k) == PortType::IN) ? Qt::AlignLeft
                                                               : Qt::AlignRight;
 
     // Draw port labels
-    painter->setPen(Qt::white); // Assuming labels are always white
-    painter->drawText(this->geometry.port_label_rects[k],
-                      align_flag,
-                      this->get_port_caption(k).c_str());
+    if (lod >= GN_STYLE->node.lod_port_labels)
+    {
+      painter->setPen(Qt::white); // Assuming labels are always white
+      painter->drawText(this->geometry.port_label_rects[k],
+                        align_flag,
+                        this->ports[k].label);
+    }
 
     // Port appearance when selected or not
     if (this->is_port_hovered[k])
@@ -415,77 +451,118 @@ void GraphicsNode::paint(QPainter                       *painter,
     }
 
     // Set port brush based on data type compatibility
-    std::string data_type = this->get_data_type(k);
-    float       port_radius = GN_STYLE->node.port_radius;
+    int   data_type_id = this->ports[k].data_type_id;
+    float port_radius = GN_STYLE->node.port_radius;
 
-    if (!this->data_type_connecting.empty() && data_type != this->data_type_connecting)
+    if (this->data_type_id_connecting >= 0 &&
+        data_type_id != this->data_type_id_connecting)
     {
       painter->setBrush(GN_STYLE->node.color_port_not_selectable);
       port_radius = GN_STYLE->node.port_radius_not_selectable;
     }
     else
-      painter->setBrush(get_color_from_data_type(data_type));
+      painter->setBrush(get_color_from_data_type_id(data_type_id));
 
     // Draw the port as a circle (ellipse with equal width and height)
     painter->drawEllipse(this->geometry.port_rects[k].center(), port_radius, port_radius);
   }
 }
 
-void GraphicsNode::reset_is_port_hovered()
+void GraphicsNode::load_ports()
 {
-  this->is_port_hovered.assign(this->is_port_hovered.size(), false);
+  // the only place where the port count is read from the proxy
+  int nports = this->p_node_proxy->get_nports();
+
+  this->caption_label = QString::fromStdString(this->p_node_proxy->get_caption());
+  this->ports.clear();
+  this->ports.reserve(nports);
+  this->port_index_by_id.clear();
+  this->port_index_by_id.reserve(nports);
+
+  for (int k = 0; k < nports; k++)
+  {
+    PortDescriptor port;
+    port.id = this->p_node_proxy->get_port_id(k);
+    port.caption = this->p_node_proxy->get_port_caption(k);
+    port.label = QString::fromStdString(port.caption);
+    port.data_type = this->p_node_proxy->get_data_type(k);
+    port.data_type_id = intern_data_type(port.data_type);
+    port.type = this->p_node_proxy->get_port_type(k);
+
+    // emplace, first port wins if ids are not unique
+    this->port_index_by_id.emplace(port.id, k);
+    this->ports.push_back(std::move(port));
+  }
+
+  this->is_port_hovered.assign(nports, false);
 }
 
-bool GraphicsNode::sceneEventFilter(QGraphicsItem *watched, QEvent *event)
+void GraphicsNode::record_from(const NodeRecord &record)
 {
-  if (GraphicsNode *node = dynamic_cast<GraphicsNode *>(watched))
-  {
+  // id and caption are owned by the node proxy
+  this->is_widget_visible = record.is_widget_visible;
+  this->is_dirty = true;
+  this->setPos(QPointF(record.x, record.y));
+}
 
-    // LOOKING FOR A PORT TO CONNECT: mouse move + connection started
-    // (from node) (watched is the node at beginning of the link and
-    // this the node currently being hovered and possibly the end of
-    // the link)
+NodeRecord GraphicsNode::record_to() const
+{
+  NodeRecord record;
 
-    if (event->type() == QEvent::GraphicsSceneMouseMove && node->has_connection_started)
-    {
-      QGraphicsSceneMouseEvent *mouse_event = static_cast<QGraphicsSceneMouseEvent *>(
-          event);
+  record.id = this->get_id();
+  record.caption = this->get_caption();
+  record.is_widget_visible = this->is_widget_visible;
+  record.x = this->scenePos().x();
+  record.y = this->scenePos().y();
 
-      QPointF item_pos = mouse_event->scenePos() - this->scenePos();
+  return record;
+}
 
-      // update current data type of the building connection
-      if (this->data_type_connecting != node->data_type_connecting)
-      {
-        this->data_type_connecting = node->data_type_connecting;
-        this->update();
-      }
+void GraphicsNode::refresh_ports()
+{
+  this->load_ports();
 
-      // update hovering port status
-      if (this->update_is_port_hovered(item_pos))
-      {
-        // if a port is hovered, check that the port type (in/out)
-        // and data type are compatible with the incoming link,
-        // deactivate hovering for this port
-        for (int k = 0; k < this->get_nports(); k++)
-          if (this->is_port_hovered[k])
-          {
-            int from_pidx = node->port_index_from;
+  // the widget is placed below the ports, recompute its position
+  QWidget *widget = this->get_qwidget_ref();
+  QSizeF   widget_size = QSizeF(-1.f, -1.f);
 
-            PortType from_ptype = node->get_port_type(from_pidx);
-            PortType to_ptype = this->get_port_type(k);
+  if (widget && widget->isVisible())
+    widget_size = widget->size();
 
-            std::string from_pdata = node->get_data_type(from_pidx);
-            std::string to_pdata = this->get_data_type(k);
+  this->update_geometry(widget_size);
 
-            if (from_ptype == to_ptype || from_pdata != to_pdata)
-              this->is_port_hovered[k] = false;
-          }
-        this->update();
-      }
-    }
-  }
+  for (QGraphicsItem *child : this->childItems())
+    if (auto *proxy_widget = qgraphicsitem_cast<QGraphicsProxyWidget *>(child))
+      proxy_widget->setPos(this->geometry.widget_pos);
 
-  return QGraphicsRectItem::sceneEventFilter(watched, event);
+  this->update_connected_links();
+  this->update();
+}
+
+void GraphicsNode::remove_connected_link(GraphicsLink *p_link)
+{
+  std::erase(this->connected_links, p_link);
+}
+
+void GraphicsNode::reset_connection_state()
+{
+  this->reset_is_port_hovered();
+  this->data_type_id_connecting = -1;
+  this->update_render_state();
+}
+
+void GraphicsNode::reset_is_port_hovered()
+{
+  this->is_port_hovered.assign(this->is_port_hovered.size(), false);
+}
+
+void GraphicsNode::set_data_type_connecting(int new_data_type_id)
+{
+  if (this->data_type_id_connecting != new_data_type_id)
+  {
+    this->data_type_id_connecting = new_data_type_id;
+    this->update_render_state();
+  }
 }
 
 void GraphicsNode::set_qwidget_visibility(bool is_visible)
@@ -503,15 +580,91 @@ void GraphicsNode::set_qwidget_visibility(bool is_visible)
   }
 
   this->update_geometry(widget_size);
+  this->update_connected_links();
   this->update();
 }
 
+void GraphicsNode::update_connected_links()
+{
+  for (GraphicsLink *p_link : this->connected_links)
+    p_link->update_path();
+}
+
+void GraphicsNode::update_render_state()
+{
+  RenderState new_state;
+  new_state.is_selected = this->isSelected();
+  new_state.is_hovered = this->is_node_hovered;
+  new_state.is_computing = this->is_node_computing;
+  new_state.hovered_port_index = this->get_hovered_port_index();
+  new_state.data_type_id_connecting = this->data_type_id_connecting;
+
+  if (new_state == this->render_state)
+    return;
+
+  RenderState previous_state = this->render_state;
+  int         previous_port_index = previous_state.hovered_port_index;
+  this->render_state = new_state;
+
+  // hovering from port to port, only the ports concerned are repainted
+  // instead of the whole node
+  previous_state.hovered_port_index = new_state.hovered_port_index;
+
+  if (previous_state != new_state)
+  {
+    schedule_item_update(this, this->boundingRect());
+    return;
+  }
+
+  QRectF dirty_rect;
+  float  extent = GN_STYLE->node.port_radius + GN_STYLE->node.pen_width_hovered;
+
+  for (int k : {previous_port_index, new_state.hovered_port_index})
+    if (k >= 0 && k < (int)this->geometry.port_rects.size())
+    {
+      QPointF center = this->geometry.port_rects[k].center();
+      dirty_rect = dirty_rect.united(this->geometry.port_rects[k])
+                       .united(QRectF(center - QPointF(extent, extent),
+                                      center + QPointF(extent, extent)));
+    }
+
+  schedule_item_update(this, dirty_rect);
+}
+
 void GraphicsNode::update_geometry(QSizeF widget_size)
 {
   this->geometry = GraphicsNodeGeometry(this->p_node_proxy, widget_size);
   this->setRect(0.f, 0.f, this->geometry.full_width, this->geometry.full_height);
 }
 
+void GraphicsNode::update_connection_hover(QPointF       scene_pos,
+                                           GraphicsNode *from,
+                                           int           port_index_from)
+{
+  QPointF item_pos = scene_pos - this->scenePos();
+
+  // update hovering port status
+  if (this->update_is_port_hovered(item_pos))
+  {
+    // if a port is hovered, check that the port type (in/out) and
+    // data type are compatible with the incoming link, deactivate
+    // hovering for this port
+    for (int k = 0; k < this->get_nports(); k++)
+      if (this->is_port_hovered[k])
+      {
+        PortType from_ptype = from->get_port_type(port_index_from);
+        PortType to_ptype = this->get_port_type(k);
+
+        int from_pdata = from->get_data_type_id(port_index_from);
+        int to_pdata = this->get_data_type_id(k);
+
+        if (from_ptype == to_ptype || from_pdata != to_pdata)
+          this->is_port_hovered[k] = false;
+      }
+    this->update_render_state();
+  }
+}
+
 bool GraphicsNode::update_is_port_hovered(QPointF item_pos)
 {
   // set hover state
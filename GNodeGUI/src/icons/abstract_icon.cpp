@@ -1,18 +1,130 @@
 /* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
-#include <QGraphicsDropShadowEffect>
+#include <algorithm>
+#include <vector>
+
 #include <QGraphicsSceneMouseEvent>
+#include <QImage>
+#include <QPainter>
 #include <QPainterPath>
 #include <QPen>
+#include <QPixmapCache>
+#include <QStyleOptionGraphicsItem>
 #include <QToolTip>
 
 #include "gnodegui/icons/abstract_icon.hpp"
 #include "gnodegui/logger.hpp"
+#include "gnodegui/style.hpp"
+
+// drop shadow, same look as the QGraphicsDropShadowEffect previously
+// attached to each icon
+#define SHADOW_BLUR_RADIUS 20
+#define SHADOW_OFFSET 4.f
 
 namespace gngui
 {
 
+// in-place box blur of the alpha channel along one direction
+static void box_blur_alpha(std::vector<float> &alpha,
+                           int                 width,
+                           int                 height,
+                           int                 radius,
+                           bool                horizontal)
+{
+  int                n = horizontal ? width : height;
+  int                nlines = horizontal ? height : width;
+  std::vector<float> line(n);
+
+  for (int j = 0; j < nlines; j++)
+  {
+    auto at = [&](int i) -> float &
+    { return horizontal ? alpha[j * width + i] : alpha[i * width + j]; };
+
+    for (int i = 0; i < n; i++)
+      line[i] = at(i);
+
+    // running sum over the window [i - radius, i + radius]
+    float sum = 0.f;
+    float norm = 1.f / (float)(2 * radius + 1);
+
+    for (int i = 0; i < std::min(radius, n); i++)
+      sum += line[i];
+
+    for (int i = 0; i < n; i++)
+    {
+      if (i + radius < n)
+        sum += line[i + radius];
+      if (i - radius - 1 >= 0)
+        sum -= line[i - radius - 1];
+      at(i) = sum * norm;
+    }
+  }
+}
+
+// blurred silhouette of the icon, rendered once per icon appearance and
+// shared through the pixmap cache
+static QPixmap get_shadow_pixmap(const QString      &key,
+                                 const QPainterPath &path,
+                                 const QPen         &pen,
+                                 const QBrush       &brush,
+                                 qreal               dpr)
+{
+  QPixmap pixmap;
+
+  if (QPixmapCache::find(key, &pixmap))
+    return pixmap;
+
+  int    margin = SHADOW_BLUR_RADIUS;
+  QRectF rect = path.boundingRect().adjusted(-margin, -margin, margin, margin);
+  QSize  size = (rect.size() * dpr).toSize().expandedTo(QSize(1, 1));
+
+  QImage image(size, QImage::Format_ARGB32_Premultiplied);
+  image.fill(Qt::transparent);
+
+  {
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.scale(dpr, dpr);
+    painter.translate(-rect.topLeft());
+    painter.setPen(pen);
+    painter.setBrush(brush);
+    painter.drawPath(path);
+  }
+
+  // three box passes in each direction, close to a gaussian blur
+  std::vector<float> alpha((size_t)size.width() * size.height());
+
+  for (int j = 0; j < size.height(); j++)
+  {
+    const QRgb *row = (const QRgb *)image.constScanLine(j);
+    for (int i = 0; i < size.width(); i++)
+      alpha[j * size.width() + i] = (float)qAlpha(row[i]);
+  }
+
+  int radius = std::max(1, (int)(SHADOW_BLUR_RADIUS * dpr / 3.f));
+
+  for (int pass = 0; pass < 3; pass++)
+  {
+    box_blur_alpha(alpha, size.width(), size.height(), radius, true);
+    box_blur_alpha(alpha, size.width(), size.height(), radius, false);
+  }
+
+  // black, only the alpha is kept (premultiplied)
+  for (int j = 0; j < size.height(); j++)
+  {
+    QRgb *row = (QRgb *)image.scanLine(j);
+    for (int i = 0; i < size.width(); i++)
+      row[i] = qRgba(0, 0, 0, std::clamp((int)alpha[j * size.width() + i], 0, 255));
+  }
+
+  pixmap = QPixmap::fromImage(image);
+  pixmap.setDevicePixelRatio(dpr);
+
+  QPixmapCache::insert(key, pixmap);
+  return pixmap;
+}
+
 AbstractIcon::AbstractIcon(float          width,
                            QColor         color,
                            float          pen_width,
@@ -27,12 +139,17 @@ AbstractIcon::AbstractIcon(float          width,
   pen.setWidth(this->pen_width);
   pen.setCapStyle(Qt::RoundCap);
   this->setPen(pen);
+  this->update_shadow_key();
+}
 
-  auto effect = new QGraphicsDropShadowEffect;
-  effect->setOffset(4, 4);
-  effect->setBlurRadius(20);
-  effect->setColor(Qt::black);
-  this->setGraphicsEffect(effect);
+QRectF AbstractIcon::boundingRect() const
+{
+  // room for the shadow
+  QRectF rect = QGraphicsPathItem::boundingRect();
+  return rect.united(rect.adjusted(-SHADOW_BLUR_RADIUS + SHADOW_OFFSET,
+                                   -SHADOW_BLUR_RADIUS + SHADOW_OFFSET,
+                                   SHADOW_BLUR_RADIUS + SHADOW_OFFSET,
+                                   SHADOW_BLUR_RADIUS + SHADOW_OFFSET));
 }
 
 void AbstractIcon::hoverEnterEvent(QGraphicsSceneHoverEvent *event)
@@ -51,6 +168,7 @@ void AbstractIcon::hoverLeaveEvent(QGraphicsSceneHoverEvent *event)
   QPen pen = this->pen();
   pen.setWidth(this->pen_width);
   this->setPen(pen);
+  this->update_shadow_key();
 
   QToolTip::hideText();
   QGraphicsPathItem::hoverLeaveEvent(event);
@@ -63,6 +181,7 @@ void AbstractIcon::mousePressEvent(QGraphicsSceneMouseEvent *event)
     QPen pen = this->pen();
     pen.setWidth(this->pen_width + 1.f);
     this->setPen(pen);
+    this->update_shadow_key();
     this->setOpacity(this->pen_opacity);
 
     Q_EMIT this->hit_icon();
@@ -77,8 +196,74 @@ void AbstractIcon::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
   QPen pen = this->pen();
   pen.setWidth(this->pen_width);
   this->setPen(pen);
+  this->update_shadow_key();
 
   QGraphicsPathItem::mouseReleaseEvent(event);
 }
 
+void AbstractIcon::paint(QPainter                       *painter,
+                         const QStyleOptionGraphicsItem *option,
+                         QWidget                        *widget)
+{
+  // the icons are details, dropped when the view is zoomed out (same
+  // threshold as the node captions)
+  if (option->levelOfDetailFromTransform(painter->worldTransform()) <
+      GN_STYLE->node.lod_caption)
+    return;
+
+  // pre-blurred shadow instead of an offscreen effect pass per frame,
+  // the key only changes with the icon appearance (or the screen)
+  qreal dpr = painter->device() ? painter->device()->devicePixelRatioF() : 1.0;
+
+  if (dpr != this->shadow_dpr)
+  {
+    this->shadow_dpr = dpr;
+    this->update_shadow_key();
+  }
+
+  QPixmap shadow = get_shadow_pixmap(this->shadow_key,
+                                     this->path(),
+                                     this->pen(),
+                                     this->brush(),
+                                     dpr);
+
+  QPointF origin = this->path().boundingRect().topLeft() -
+                   QPointF(SHADOW_BLUR_RADIUS, SHADOW_BLUR_RADIUS) +
+                   QPointF(SHADOW_OFFSET, SHADOW_OFFSET);
+  painter->drawPixmap(origin, shadow);
+
+  QGraphicsPathItem::paint(painter, option, widget);
+}
+
+void AbstractIcon::set_icon_path(const QPainterPath &path)
+{
+  this->setPath(path);
+  this->update_shadow_key();
+}
+
+void AbstractIcon::update_shadow_key()
+{
+  // the path depends on the icon state (see set_path), it is part of
+  // the key
+  size_t             hash = 0;
+  const QPainterPath path = this->path();
+
+  for (int k = 0; k < path.elementCount(); k++)
+  {
+    QPainterPath::Element e = path.elementAt(k);
+    hash = qHashMulti(hash, (int)e.type, e.x, e.y);
+  }
+
+  this->shadow_key =
+      QString("gngui_icon_shadow_%1_%2_%3_%4_%5_%6_%7_%8")
+          .arg(QString::fromLatin1(this->metaObject()->className()))
+          .arg(this->width)
+          .arg(this->pen().widthF())
+          .arg((int)this->pen().style())
+          .arg(this->pen().color().rgba())
+          .arg(this->brush().style() == Qt::NoBrush ? 0 : this->brush().color().rgba())
+          .arg(this->shadow_dpr)
+          .arg((qulonglong)hash);
+}
+
 } // namespace gngui
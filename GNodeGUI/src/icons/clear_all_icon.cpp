@@ -41,7 +41,7 @@ void ClearAllIcon::set_path()
   path.moveTo(lm - dx, lm + dx);
   path.lineTo(lm + dx, lm - dx);
 
-  this->setPath(path);
+  this->set_icon_path(path);
 }
 
 } // namespace gngui
@@ -37,7 +37,7 @@ void DotsIcon::set_path()
   path.addEllipse(QPointF(2.f * dx, lm), radius, radius);
   path.addEllipse(QPointF(3.f * dx, lm), radius, radius);
 
-  this->setPath(path);
+  this->set_icon_path(path);
 }
 
 } // namespace gngui
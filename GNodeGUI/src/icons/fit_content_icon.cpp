@@ -51,7 +51,7 @@ void FitContentIcon::set_path()
   path.lineTo(this->width, lm);
   path.lineTo(this->width - dm, lm + dm);
 
-  this->setPath(path);
+  this->set_icon_path(path);
 }
 
 } // namespace gngui
@@ -33,7 +33,7 @@ void GroupIcon::set_path()
   path.addRect(QRectF(this->width - dx - lx, dx, lx, lx));
   path.addRect(QRectF(dx, this->width - dx - lx, lx, lx));
 
-  this->setPath(path);
+  this->set_icon_path(path);
 }
 
 } // namespace gngui
@@ -41,7 +41,7 @@ void LinkTypeIcon::set_path()
   path.lineTo(this->width - 2.f * dx, this->width - dx);
   path.lineTo(this->width - dx, this->width - dx);
 
-  this->setPath(path);
+  this->set_icon_path(path);
 }
 
 } // namespace gngui
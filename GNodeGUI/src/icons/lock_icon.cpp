@@ -48,7 +48,7 @@ void LockIcon::set_path()
     path.lineTo(lm + radius, 0.5f * this->width - dy);
   }
 
-  this->setPath(path);
+  this->set_icon_path(path);
 }
 
 } // namespace gngui
@@ -34,7 +34,7 @@ void NewIcon::set_path()
   path.moveTo(lm, lm - dx);
   path.lineTo(lm, lm + dx);
 
-  this->setPath(path);
+  this->set_icon_path(path);
 }
 
 } // namespace gngui
@@ -33,7 +33,7 @@ void ScreenshotIcon::set_path()
   QPointF center(rect.center());
   path.addEllipse(center, 0.2f * this->width, 0.2f * this->width);
 
-  this->setPath(path);
+  this->set_icon_path(path);
 }
 
 } // namespace gngui
@@ -0,0 +1,26 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+
+#include "gnodegui/string_interner.hpp"
+
+namespace gngui
+{
+
+int StringInterner::find(const std::string &string) const
+{
+  auto it = this->ids.find(string);
+  return it == this->ids.end() ? -1 : it->second;
+}
+
+int StringInterner::intern(const std::string &string)
+{
+  auto [it, inserted] = this->ids.try_emplace(string, this->size());
+
+  if (inserted)
+    this->strings.push_back(string);
+
+  return it->second;
+}
+
+} // namespace gngui
@@ -3,10 +3,18 @@
  * this software. */
 
 #include "gnodegui/style.hpp"
+#include "gnodegui/string_interner.hpp"
 
 namespace gngui
 {
 
+// data types and categories ids, shared by all the nodes, and the
+// colors indexed by these ids (resolved lazily from the style maps)
+static StringInterner      data_type_interner;
+static StringInterner      category_interner;
+static std::vector<QColor> data_type_colors;
+static std::vector<QColor> category_colors;
+
 // Initialize the static member
 std::shared_ptr<Style> Style::instance = nullptr;
 
@@ -25,4 +33,55 @@ QColor get_color_from_data_type(const std::string &data_type)
     return GN_STYLE->node.color_port_data_default;
 }
 
+QColor get_color_from_data_type_id(int data_type_id)
+{
+  if (data_type_id < 0)
+    return GN_STYLE->node.color_port_data_default;
+
+  // resolve the colors of the types interned since the last call
+  while ((int)data_type_colors.size() <= data_type_id)
+  {
+    int id = (int)data_type_colors.size();
+    data_type_colors.push_back(
+        get_color_from_data_type(data_type_interner.get_string(id)));
+  }
+
+  return data_type_colors[data_type_id];
+}
+
+QColor get_color_from_category_id(int category_id)
+{
+  if (category_id < 0)
+    return GN_STYLE->node.color_bg_light;
+
+  while ((int)category_colors.size() <= category_id)
+  {
+    const std::string &category = category_interner.get_string(
+        (int)category_colors.size());
+
+    if (GN_STYLE->node.color_category.contains(category))
+      category_colors.push_back(GN_STYLE->node.color_category.at(category));
+    else
+      category_colors.push_back(GN_STYLE->node.color_bg_light);
+  }
+
+  return category_colors[category_id];
+}
+
+int intern_category(const std::string &category)
+{
+  return category_interner.intern(category);
+}
+
+int intern_data_type(const std::string &data_type)
+{
+  return data_type_interner.intern(data_type);
+}
+
+void refresh_interned_colors()
+{
+  data_type_colors.clear();
+  category_colors.clear();
+}
+
 } // namespace gngui
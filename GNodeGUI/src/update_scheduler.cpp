@@ -0,0 +1,85 @@
+/* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <unordered_map>
+
+#include <QElapsedTimer>
+#include <QTimer>
+
+#include "gnodegui/style.hpp"
+#include "gnodegui/update_scheduler.hpp"
+
+namespace gngui
+{
+
+// pending requests (GUI thread only)
+static std::unordered_map<QGraphicsItem *, QRectF> pending_updates;
+
+static void flush_item_updates();
+
+static QElapsedTimer &get_flush_clock()
+{
+  static QElapsedTimer clock;
+  return clock;
+}
+
+static QTimer *get_flush_timer()
+{
+  static QTimer *timer = nullptr;
+
+  if (!timer)
+  {
+    timer = new QTimer();
+    timer->setSingleShot(true);
+    QObject::connect(timer, &QTimer::timeout, []() { flush_item_updates(); });
+  }
+
+  return timer;
+}
+
+static void flush_item_updates()
+{
+  // swapped first, an update can trigger new requests
+  std::unordered_map<QGraphicsItem *, QRectF> updates;
+  updates.swap(pending_updates);
+
+  for (auto &[item, rect] : updates)
+    item->update(rect);
+
+  get_flush_clock().restart();
+}
+
+void cancel_item_update(QGraphicsItem *item)
+{
+  pending_updates.erase(item);
+}
+
+void schedule_item_update(QGraphicsItem *item, const QRectF &rect)
+{
+  int max_rate = GN_STYLE->viewer.max_repaint_rate;
+
+  if (max_rate <= 0)
+  {
+    item->update(rect);
+    return;
+  }
+
+  QRectF &pending = pending_updates[item];
+  pending = pending.united(rect);
+
+  QTimer *timer = get_flush_timer();
+
+  if (timer->isActive())
+    return;
+
+  // flushed now if the previous flush is old enough, or at the next
+  // slot otherwise
+  int interval = 1000 / max_rate;
+
+  if (!get_flush_clock().isValid() || get_flush_clock().elapsed() >= interval)
+    flush_item_updates();
+  else
+    timer->start(interval - (int)get_flush_clock().elapsed());
+}
+
+} // namespace gngui
@@ -1,7 +1,11 @@
 /* Copyright (c) 2024 Otto Link. Distributed under the terms of the GNU General
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -27,6 +31,21 @@ QRectF compute_bounding_rect(const std::vector<QGraphicsItem *> &items)
   return bounding_rect;
 }
 
+float distance_to_segment_squared(const QPointF &p, const QPointF &a, const QPointF &b)
+{
+  QPointF ab = b - a;
+  QPointF ap = p - a;
+  float   length_squared = QPointF::dotProduct(ab, ab);
+
+  // projection of the point on the segment, clamped to its end points
+  float t = 0.f;
+  if (length_squared > 0.f)
+    t = std::clamp((float)QPointF::dotProduct(ap, ab) / length_squared, 0.f, 1.f);
+
+  QPointF delta = ap - t * ab;
+  return QPointF::dotProduct(delta, delta);
+}
+
 std::vector<std::string> split_string(const std::string &string, char delimiter)
 {
   std::vector<std::string> result;
@@ -39,4 +58,28 @@ std::vector<std::string> split_string(const std::string &string, char delimiter)
   return result;
 }
 
+void write_file_atomic(const std::string &fname, const std::string &buffer)
+{
+  std::string fname_tmp = fname + ".tmp";
+
+  {
+    std::ofstream file(fname_tmp, std::ios::binary | std::ios::trunc);
+
+    if (!file.is_open())
+      throw std::runtime_error("Failed to open file: " + fname_tmp);
+
+    file.write(buffer.data(), (std::streamsize)buffer.size());
+
+    if (!file)
+      throw std::runtime_error("Failed to write file: " + fname_tmp);
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(fname_tmp, fname, ec);
+
+  if (ec)
+    throw std::runtime_error("Failed to rename file: " + fname_tmp + " (" + ec.message() +
+                             ")");
+}
+
 } // namespace gngui
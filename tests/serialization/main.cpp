@@ -0,0 +1,341 @@
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "nlohmann/json.hpp"
+
+#include "gnodegui/graph_binary.hpp"
+#include "gnodegui/graph_compression.hpp"
+#include "gnodegui/graph_json_sax.hpp"
+#include "gnodegui/graph_patch.hpp"
+#include "gnodegui/graph_record.hpp"
+
+// round trips of a graph record through all the serialization formats,
+// and invalid inputs that must be rejected
+
+using namespace gngui;
+
+static int nfailures = 0;
+
+#define CHECK(condition)                                                            \
+  do                                                                                \
+  {                                                                                 \
+    if (!(condition))                                                               \
+    {                                                                               \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": failed: " #condition "\n";     \
+      nfailures++;                                                                  \
+    }                                                                               \
+  } while (0)
+
+// --- helpers
+
+template <typename E> static bool throws(const std::function<void()> &f)
+{
+  try
+  {
+    f();
+  }
+  catch (const E &)
+  {
+    return true;
+  }
+  catch (...)
+  {
+    return false;
+  }
+  return false;
+}
+
+// same content, item order ignored (LinkRecord has no operator==)
+static bool is_same_graph(GraphRecord a, GraphRecord b)
+{
+  sort_graph_record(a);
+  sort_graph_record(b);
+
+  if (a.id != b.id || a.current_link_type != b.current_link_type ||
+      a.nodes != b.nodes || a.groups != b.groups || a.links.size() != b.links.size())
+    return false;
+
+  for (size_t k = 0; k < a.links.size(); k++)
+    if (!is_same_link(a.links[k], b.links[k]) ||
+        a.links[k].link_type != b.links[k].link_type)
+      return false;
+
+  return true;
+}
+
+static GraphRecord make_graph()
+{
+  GraphRecord record;
+
+  record.id = "graph \"main\"";
+  record.current_link_type = 1;
+
+  // ids and captions with characters that need escaping
+  record.nodes = {{"n3", "Noise\\Fbm", true, -120.5, 64.25},
+                  {"n1", "Remap \"01\"", false, 0.0, 0.0},
+                  {"n2", "Gradient\nnorm", true, 1e6, -3.125},
+                  {"n4", "Élévation", true, 42.0, 7.5}};
+
+  record.links = {{"n1", "out", "n2", "in", 1},
+                  {"n3", "out", "n2", "dx", 1},
+                  {"n3", "out", "n4", "in", 1},
+                  {"n2", "out", "n4", "mask", 1}};
+
+  record.groups = {{"terrain", -200.0, -100.0, 400.0, 300.0, {255, 0, 0, 128}},
+                   {"", 10.0, 20.0, 30.0, 40.0, {0, 0, 0, 0}}};
+
+  return record;
+}
+
+// a few edits of every kind: move, removal (with its links), addition,
+// groups and link type
+static GraphRecord make_edited_graph()
+{
+  GraphRecord record = make_graph();
+
+  record.current_link_type = 3;
+  record.nodes[0].x += 50.0;
+  record.nodes[3].caption = "Elevation";
+  std::erase_if(record.nodes, [](const NodeRecord &node) { return node.id == "n1"; });
+  std::erase_if(record.links,
+                [](const LinkRecord &link) { return link.node_out_id == "n1"; });
+
+  record.nodes.push_back({"n5", "Erosion", true, 300.0, 0.0});
+  record.links.push_back({"n4", "out", "n5", "in", 3});
+  record.groups.pop_back();
+
+  for (auto &link : record.links)
+    link.link_type = record.current_link_type;
+
+  return record;
+}
+
+// --- round trips
+
+static void test_json()
+{
+  GraphRecord record = make_graph();
+
+  GraphRecord from_json = graph_record_from_json(graph_record_to_json(record));
+  CHECK(is_same_graph(from_json, record));
+
+  GraphRecord from_dump = graph_record_from_json(
+      nlohmann::json::parse(graph_record_dump(record)));
+  CHECK(is_same_graph(from_dump, record));
+
+  // streaming reader, on both key orders (nodes first in the dump)
+  for (const std::string &text :
+       {graph_record_dump(record), graph_record_to_json(record).dump()})
+  {
+    GraphRecord           from_sax;
+    GraphJsonSaxCallbacks callbacks;
+
+    callbacks.on_id = [&](const std::string &id) { from_sax.id = id; };
+    callbacks.on_current_link_type = [&](int link_type)
+    { from_sax.current_link_type = link_type; };
+    callbacks.on_group = [&](GroupRecord &&group)
+    { from_sax.groups.push_back(std::move(group)); };
+    callbacks.on_link = [&](LinkRecord &&link)
+    { from_sax.links.push_back(std::move(link)); };
+    callbacks.on_node = [&](NodeRecord &&node)
+    { from_sax.nodes.push_back(std::move(node)); };
+
+    std::istringstream is(text);
+    read_graph_json_sax(is, callbacks);
+    CHECK(is_same_graph(from_sax, record));
+  }
+
+  // empty graph
+  GraphRecord empty;
+  CHECK(is_same_graph(graph_record_from_json(graph_record_to_json(empty)), empty));
+}
+
+static void test_binary()
+{
+  GraphRecord record = make_graph();
+  std::string buffer = graph_record_to_binary(record);
+
+  CHECK(is_graph_binary(buffer));
+  CHECK(is_same_graph(graph_record_from_binary(buffer), record));
+
+  GraphRecord empty;
+  CHECK(is_same_graph(graph_record_from_binary(graph_record_to_binary(empty)), empty));
+}
+
+static void test_compression()
+{
+  GraphRecord record = make_graph();
+
+  for (const std::string &payload :
+       {graph_record_to_binary(record), graph_record_dump(record)})
+  {
+    // small blocks, several of them are decompressed in parallel
+    std::string compressed = graph_compress(payload, -1, 16);
+
+    CHECK(is_graph_compressed(compressed));
+    CHECK(graph_decompress(compressed) == payload);
+    CHECK(graph_decompress(graph_compress(payload)) == payload);
+  }
+
+  std::string compressed = graph_compress(graph_record_to_binary(record));
+  CHECK(is_same_graph(graph_record_from_binary(graph_decompress(compressed)), record));
+
+  CHECK(graph_decompress(graph_compress("")).empty());
+}
+
+static void test_patch()
+{
+  GraphRecord from = make_graph();
+  GraphRecord to = make_edited_graph();
+
+  GraphPatch patch = graph_diff(from, to);
+  CHECK(!patch.is_empty());
+  CHECK(graph_diff(from, from).is_empty());
+
+  GraphRecord patched = from;
+  apply_graph_patch(patched, patch);
+  CHECK(is_same_graph(patched, to));
+
+  // through the JSON form of the patch
+  patched = from;
+  apply_graph_patch(patched, graph_patch_from_json(graph_patch_to_json(patch)));
+  CHECK(is_same_graph(patched, to));
+
+  // journal replay: one patch per line, from an empty graph
+  GraphRecord intermediate = make_graph();
+  intermediate.nodes[1].x = -1.0;
+
+  std::string journal;
+  journal += graph_patch_to_json(graph_diff(GraphRecord(), intermediate)).dump() + "\n";
+  journal += "\n";
+  journal += graph_patch_to_json(graph_diff(intermediate, to)).dump() + "\n";
+
+  // the id is not part of the patches
+  GraphRecord replayed;
+  replayed.id = to.id;
+
+  std::istringstream is(journal);
+  apply_graph_journal(replayed, is);
+  CHECK(is_same_graph(replayed, to));
+}
+
+// --- invalid inputs
+
+static void test_invalid_binary()
+{
+  std::string buffer = graph_record_to_binary(make_graph());
+
+  // every truncation of the buffer
+  for (size_t size = 0; size < buffer.size(); size++)
+  {
+    std::string truncated = buffer.substr(0, size);
+    CHECK(throws<std::runtime_error>([&]() { graph_record_from_binary(truncated); }));
+  }
+
+  std::string bad_magic = buffer;
+  bad_magic[0] ^= 0x20;
+  CHECK(!is_graph_binary(bad_magic));
+  CHECK(throws<std::runtime_error>([&]() { graph_record_from_binary(bad_magic); }));
+
+  CHECK(throws<std::runtime_error>([]() { graph_record_from_binary("not a graph"); }));
+}
+
+static void test_invalid_compression()
+{
+  std::string payload = graph_record_dump(make_graph());
+  std::string compressed = graph_compress(payload, -1, 64);
+
+  // layout: magic, version, block count, then (raw size, compressed
+  // size) per block, all u32 little-endian
+  auto put_u32 = [](std::string &buffer, size_t pos, uint32_t value)
+  {
+    for (int k = 0; k < 4; k++)
+      buffer[pos + k] = (char)((value >> (8 * k)) & 0xFF);
+  };
+
+  for (size_t size = 0; size < compressed.size(); size++)
+  {
+    std::string truncated = compressed.substr(0, size);
+    CHECK(throws<std::runtime_error>([&]() { graph_decompress(truncated); }));
+  }
+
+  // raw size far beyond what the compressed block can hold, rejected
+  // before any allocation
+  std::string huge_block = compressed;
+  put_u32(huge_block, 12, 0xFFFFFFFF);
+  CHECK(throws<std::runtime_error>([&]() { graph_decompress(huge_block); }));
+
+  std::string huge_count = compressed;
+  put_u32(huge_count, 8, 0x7FFFFFFF);
+  CHECK(throws<std::runtime_error>([&]() { graph_decompress(huge_count); }));
+
+  std::string bad_version = compressed;
+  put_u32(bad_version, 4, 99);
+  CHECK(throws<std::runtime_error>([&]() { graph_decompress(bad_version); }));
+
+  // raw size not matching the stream
+  std::string bad_size = compressed;
+  put_u32(bad_size, 12, 63);
+  CHECK(throws<std::runtime_error>([&]() { graph_decompress(bad_size); }));
+
+  std::string corrupted = compressed;
+  corrupted[corrupted.size() - 3] ^= 0x5A;
+  CHECK(throws<std::runtime_error>([&]() { graph_decompress(corrupted); }));
+
+  CHECK(throws<std::runtime_error>([&]() { graph_decompress(payload); }));
+}
+
+static void test_invalid_json()
+{
+  std::string text = graph_record_dump(make_graph());
+
+  GraphJsonSaxCallbacks callbacks;
+
+  for (size_t size : {(size_t)0, (size_t)1, text.size() / 2, text.size() - 1})
+  {
+    std::istringstream is(text.substr(0, size));
+    CHECK(throws<std::runtime_error>([&]() { read_graph_json_sax(is, callbacks); }));
+  }
+
+  // missing required keys and wrong types (captions, flags and the
+  // lists are optional)
+  nlohmann::json json = graph_record_to_json(make_graph());
+  json["nodes"][0].erase("id");
+  CHECK(throws<nlohmann::json::exception>([&]() { graph_record_from_json(json); }));
+
+  json = graph_record_to_json(make_graph());
+  json["links"][1].erase("port_in_id");
+  CHECK(throws<nlohmann::json::exception>([&]() { graph_record_from_json(json); }));
+
+  json = graph_record_to_json(make_graph());
+  json["nodes"][2]["scene_position.x"] = "left";
+  CHECK(throws<nlohmann::json::exception>([&]() { graph_record_from_json(json); }));
+
+  // journal with a broken line
+  GraphRecord        record;
+  std::istringstream is("{\"clear\":true}\n{\"added_nodes\":[");
+  CHECK(throws<nlohmann::json::exception>([&]() { apply_graph_journal(record, is); }));
+}
+
+int main()
+{
+  test_json();
+  test_binary();
+  test_compression();
+  test_patch();
+  test_invalid_binary();
+  test_invalid_compression();
+  test_invalid_json();
+
+  if (nfailures)
+  {
+    std::cerr << nfailures << " check(s) failed\n";
+    return 1;
+  }
+
+  std::cout << "all checks passed\n";
+  return 0;
+}